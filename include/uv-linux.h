@@ -26,6 +26,34 @@
   uv__io_t inotify_read_watcher;                                              \
   void* inotify_watchers;                                                     \
   int inotify_fd;                                                             \
+  void* ready_queue[2];                                                       \
+  void* iou;                                                                  \
+  uint64_t busy_poll;                                                         \
+  void* poll_events;                                                          \
+  unsigned int poll_nevents;                                                  \
+  unsigned int poll_batch;                                                    \
+  unsigned int poll_budget;                                                   \
+  unsigned int poll_streak;                                                   \
+  uv__io_t hrtimer_watcher;                                                   \
+  struct {                                                                    \
+    void* min;                                                                \
+    unsigned int nelts;                                                       \
+    unsigned int nalloc;                                                      \
+  } hrtimer_heap;                                                             \
+  uint64_t hrtimer_armed;                                                     \
+  uint64_t tsc_base;                                                          \
+  uint64_t tsc_base_ns;                                                       \
+
+#define UV_IO_PRIVATE_PLATFORM_FIELDS                                         \
+  void* ready_queue[2];                                                       \
+  /* Readiness reported by EPOLLET that the owner hasn't consumed yet. */     \
+  unsigned int ready;                                                         \
+  /* Non-zero if the owner drains the fd and calls uv__io_drained(). */       \
+  int edge;                                                                   \
+  /* Events the kernel reported that the watcher no longer wants. */         \
+  unsigned int unwanted;                                                      \
+  /* io_uring backend: id of the poll request in flight, 0 if none. */       \
+  unsigned int poll_id;                                                       \
 
 #define UV_PLATFORM_FS_EVENT_FIELDS                                           \
   void* watchers[2];                                                          \
@@ -32,6 +32,10 @@ struct uv__work {
   void (*done)(struct uv__work *w, int status);
   struct uv_loop_s* loop;
   void* wq[2];
+  uint64_t submit_time;
+  struct uv_serial_s* serial;
+  int kind;  /* Only kept for requests of a serial queue. */
+  unsigned int worker;  /* Whose queue it was last put in. */
 };
 
 #endif /* UV_THREADPOOL_H_ */
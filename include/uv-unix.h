@@ -217,6 +217,8 @@ typedef struct {
   void* wq[2];                                                                \
   uv_mutex_t wq_mutex;                                                        \
   uv_async_t wq_async;                                                        \
+  unsigned int wq_slot;                                                       \
+  void* wq_completed;                                                         \
   uv_rwlock_t cloexec_lock;                                                   \
   uv_handle_t* closing_handles;                                               \
   void* process_handles[2];                                                   \
@@ -224,17 +226,23 @@ typedef struct {
   void* check_handles[2];                                                     \
   void* idle_handles[2];                                                      \
   void* async_handles[2];                                                     \
+  void* async_pending;                                                        \
   struct uv__async async_watcher;                                             \
   struct {                                                                    \
     void* min;                                                                \
     unsigned int nelts;                                                       \
+    unsigned int nalloc;                                                      \
   } timer_heap;                                                               \
   uint64_t timer_counter;                                                     \
+  void* timer_wheel;                                                          \
   uint64_t time;                                                              \
+  uint64_t time_ns;                                                           \
   int signal_pipefd[2];                                                       \
   uv__io_t signal_io_watcher;                                                 \
   uv_signal_t child_watcher;                                                  \
   int emfile_fd;                                                              \
+  uv_metrics_t metrics;                                                       \
+  void* lag;                                                                  \
   UV_PLATFORM_LOOP_FIELDS                                                     \
 
 #define UV_REQ_TYPE_PRIVATE /* empty */
@@ -312,12 +320,21 @@ typedef struct {
   uv_async_cb async_cb;                                                       \
   void* queue[2];                                                             \
   int pending;                                                                \
+  void* next_pending;                                                         \
+
+#define UV_CHANNEL_PRIVATE_FIELDS                                             \
+  uv_async_t wakeup;                                                          \
+  void* slots;                                                                \
+  unsigned long mask;                                                         \
+  unsigned long head;                                                         \
+  unsigned long tail;                                                         \
 
 #define UV_TIMER_PRIVATE_FIELDS                                               \
   uv_timer_cb timer_cb;                                                       \
   void* heap_node[3];                                                         \
   uint64_t timeout;                                                           \
   uint64_t repeat;                                                            \
+  uint64_t slack;                                                             \
   uint64_t start_id;
 
 #define UV_GETADDRINFO_PRIVATE_FIELDS                                         \
@@ -360,6 +377,11 @@ typedef struct {
 #define UV_WORK_PRIVATE_FIELDS                                                \
   struct uv__work work_req;
 
+#define UV_SERIAL_PRIVATE_FIELDS                                              \
+  uv_mutex_t mutex;                                                           \
+  void* queue[2];                                                             \
+  struct uv__work* active;
+
 #define UV_TTY_PRIVATE_FIELDS                                                 \
   struct termios orig_termios;                                                \
   int mode;
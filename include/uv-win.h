@@ -337,7 +337,9 @@ RB_HEAD(uv_timer_tree_s, uv_timer_s);
   /* Threadpool */                                                            \
   void* wq[2];                                                                \
   uv_mutex_t wq_mutex;                                                        \
-  uv_async_t wq_async;
+  uv_async_t wq_async;                                                        \
+  unsigned int wq_slot;                                                       \
+  void* wq_completed;
 
 #define UV_REQ_TYPE_PRIVATE                                                   \
   /* TODO: remove the req suffix */                                           \
@@ -522,6 +524,7 @@ RB_HEAD(uv_timer_tree_s, uv_timer_s);
   RB_ENTRY(uv_timer_s) tree_entry;                                            \
   uint64_t due;                                                               \
   uint64_t repeat;                                                            \
+  uint64_t slack;                                                             \
   uint64_t start_id;                                                          \
   uv_timer_cb timer_cb;
 
@@ -531,6 +534,8 @@ RB_HEAD(uv_timer_tree_s, uv_timer_s);
   /* char to avoid alignment issues */                                        \
   char volatile async_sent;
 
+#define UV_CHANNEL_PRIVATE_FIELDS /* empty */
+
 #define UV_PREPARE_PRIVATE_FIELDS                                             \
   uv_prepare_t* prepare_prev;                                                 \
   uv_prepare_t* prepare_next;                                                 \
@@ -611,6 +616,11 @@ RB_HEAD(uv_timer_tree_s, uv_timer_s);
 #define UV_WORK_PRIVATE_FIELDS                                                \
   struct uv__work work_req;
 
+#define UV_SERIAL_PRIVATE_FIELDS                                              \
+  uv_mutex_t mutex;                                                           \
+  void* queue[2];                                                             \
+  struct uv__work* active;
+
 #define UV_FS_EVENT_PRIVATE_FIELDS                                            \
   struct uv_fs_event_req_s {                                                  \
     UV_REQ_FIELDS                                                             \
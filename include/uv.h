@@ -157,6 +157,7 @@ extern "C" {
   XX(TTY, tty)                                                                \
   XX(UDP, udp)                                                                \
   XX(SIGNAL, signal)                                                          \
+  XX(CHANNEL, channel)                                                        \
 
 #define UV_REQ_TYPE_MAP(XX)                                                   \
   XX(REQ, req)                                                                \
@@ -213,6 +214,7 @@ typedef struct uv_process_s uv_process_t;
 typedef struct uv_fs_event_s uv_fs_event_t;
 typedef struct uv_fs_poll_s uv_fs_poll_t;
 typedef struct uv_signal_s uv_signal_t;
+typedef struct uv_channel_s uv_channel_t;
 
 /* Request types. */
 typedef struct uv_req_s uv_req_t;
@@ -224,22 +226,63 @@ typedef struct uv_connect_s uv_connect_t;
 typedef struct uv_udp_send_s uv_udp_send_t;
 typedef struct uv_fs_s uv_fs_t;
 typedef struct uv_work_s uv_work_t;
+typedef struct uv_serial_s uv_serial_t;
 
 /* None of the above. */
 typedef struct uv_cpu_info_s uv_cpu_info_t;
 typedef struct uv_interface_address_s uv_interface_address_t;
 typedef struct uv_dirent_s uv_dirent_t;
+typedef struct uv_metrics_s uv_metrics_t;
 
 typedef enum {
-  UV_LOOP_BLOCK_SIGNAL
+  UV_LOOP_BLOCK_SIGNAL,
+  UV_LOOP_EDGE_TRIGGERED,
+  UV_LOOP_USE_IO_URING,
+  UV_LOOP_BUSY_POLL,
+  UV_LOOP_POLL_BATCH,
+  UV_LOOP_METRICS_TIME,
+  UV_LOOP_LAG_HISTOGRAM,
+  UV_LOOP_TIMER_WHEEL,
+  UV_LOOP_CLOCK_MODE
 } uv_loop_option;
 
+typedef enum {
+  UV_CLOCK_MODE_DEFAULT,
+  UV_CLOCK_MODE_PRECISE,
+  UV_CLOCK_MODE_FAST
+} uv_clock_mode;
+
+typedef enum {
+  UV_LAG_TIMER,
+  UV_LAG_ITERATION
+} uv_lag_type;
+
 typedef enum {
   UV_RUN_DEFAULT = 0,
   UV_RUN_ONCE,
   UV_RUN_NOWAIT
 } uv_run_mode;
 
+struct uv_metrics_s {
+  uint64_t loop_count;
+  uint64_t events;
+  uint64_t polls;
+  uint64_t callbacks;
+  uint64_t backend_ctl;
+  uint64_t backend_ctl_saved;
+  uint64_t busy_poll_hits;
+  uint64_t busy_poll_misses;
+  /* Nanoseconds, only measured with UV_LOOP_METRICS_TIME. */
+  uint64_t loop_time;
+  uint64_t idle_time;
+  uint64_t timers_time;
+  uint64_t pending_time;
+  uint64_t prepare_time;
+  uint64_t poll_time;
+  uint64_t check_time;
+  uint64_t closing_time;
+};
+
 
 UV_EXTERN unsigned int uv_version(void);
 UV_EXTERN const char* uv_version_string(void);
@@ -282,10 +325,18 @@ UV_EXTERN int uv_has_ref(const uv_handle_t*);
 
 UV_EXTERN void uv_update_time(uv_loop_t*);
 UV_EXTERN uint64_t uv_now(const uv_loop_t*);
+UV_EXTERN uint64_t uv_now_ns(const uv_loop_t*);
 
 UV_EXTERN int uv_backend_fd(const uv_loop_t*);
 UV_EXTERN int uv_backend_timeout(const uv_loop_t*);
 
+UV_EXTERN int uv_loop_metrics(const uv_loop_t* loop, uv_metrics_t* metrics);
+UV_EXTERN int uv_loop_lag(const uv_loop_t* loop,
+                          uv_lag_type type,
+                          double percentile,
+                          uint64_t* value);
+UV_EXTERN int uv_loop_lag_reset(uv_loop_t* loop);
+
 typedef void (*uv_alloc_cb)(uv_handle_t* handle,
                             size_t suggested_size,
                             uv_buf_t* buf);
@@ -300,6 +351,7 @@ typedef void (*uv_close_cb)(uv_handle_t* handle);
 typedef void (*uv_poll_cb)(uv_poll_t* handle, int status, int events);
 typedef void (*uv_timer_cb)(uv_timer_t* handle);
 typedef void (*uv_async_cb)(uv_async_t* handle);
+typedef void (*uv_channel_cb)(uv_channel_t* channel, void* arg);
 typedef void (*uv_prepare_cb)(uv_prepare_t* handle);
 typedef void (*uv_check_cb)(uv_check_t* handle);
 typedef void (*uv_idle_cb)(uv_idle_t* handle);
@@ -428,6 +480,9 @@ UV_EXTERN void uv_close(uv_handle_t* handle, uv_close_cb close_cb);
 
 UV_EXTERN int uv_send_buffer_size(uv_handle_t* handle, int* value);
 UV_EXTERN int uv_recv_buffer_size(uv_handle_t* handle, int* value);
+UV_EXTERN int uv_incoming_cpu(uv_handle_t* handle, int cpu);
+UV_EXTERN int uv_reuseport_steer_cpu(uv_handle_t* handle,
+                                     unsigned int nsockets);
 
 UV_EXTERN int uv_fileno(const uv_handle_t* handle, uv_os_fd_t* fd);
 
@@ -516,7 +571,12 @@ UV_EXTERN int uv_tcp_simultaneous_accepts(uv_tcp_t* handle, int enable);
 
 enum uv_tcp_flags {
   /* Used with uv_tcp_bind, when an IPv6 address is used. */
-  UV_TCP_IPV6ONLY = 1
+  UV_TCP_IPV6ONLY = 1,
+  /*
+   * Sets SO_REUSEPORT, so that several sockets can listen on the same address
+   * and port. The kernel distributes incoming connections between them.
+   */
+  UV_TCP_REUSEPORT = 2
 };
 
 UV_EXTERN int uv_tcp_bind(uv_tcp_t* handle,
@@ -562,7 +622,12 @@ enum uv_udp_flags {
    * (provided they all set the flag) but only the last one to bind will receive
    * any traffic, in effect "stealing" the port from the previous listener.
    */
-  UV_UDP_REUSEADDR = 4
+  UV_UDP_REUSEADDR = 4,
+  /*
+   * Sets SO_REUSEPORT. On Linux the kernel distributes the incoming datagrams
+   * between all sockets that are bound to the same address with this flag.
+   */
+  UV_UDP_REUSEPORT = 8
 };
 
 typedef void (*uv_udp_send_cb)(uv_udp_send_t* req, int status);
@@ -759,6 +824,25 @@ UV_EXTERN int uv_async_init(uv_loop_t*,
 UV_EXTERN int uv_async_send(uv_async_t* async);
 
 
+/*
+ * uv_channel_t is a subclass of uv_handle_t.
+ *
+ * Bounded queue of (callback, argument) pairs that any thread can post to.
+ * The callbacks run on the loop thread.
+ */
+struct uv_channel_s {
+  UV_HANDLE_FIELDS
+  UV_CHANNEL_PRIVATE_FIELDS
+};
+
+UV_EXTERN int uv_channel_init(uv_loop_t*,
+                              uv_channel_t* channel,
+                              unsigned int capacity);
+UV_EXTERN int uv_channel_send(uv_channel_t* channel,
+                              uv_channel_cb cb,
+                              void* arg);
+
+
 /*
  * uv_timer_t is a subclass of uv_handle_t.
  *
@@ -774,10 +858,16 @@ UV_EXTERN int uv_timer_start(uv_timer_t* handle,
                              uv_timer_cb cb,
                              uint64_t timeout,
                              uint64_t repeat);
+UV_EXTERN int uv_timer_start_ns(uv_timer_t* handle,
+                                uv_timer_cb cb,
+                                uint64_t timeout,
+                                uint64_t repeat);
 UV_EXTERN int uv_timer_stop(uv_timer_t* handle);
 UV_EXTERN int uv_timer_again(uv_timer_t* handle);
 UV_EXTERN void uv_timer_set_repeat(uv_timer_t* handle, uint64_t repeat);
 UV_EXTERN uint64_t uv_timer_get_repeat(const uv_timer_t* handle);
+UV_EXTERN void uv_timer_set_slack(uv_timer_t* handle, uint64_t slack);
+UV_EXTERN uint64_t uv_timer_get_slack(const uv_timer_t* handle);
 
 
 /*
@@ -959,10 +1049,78 @@ struct uv_work_s {
   UV_WORK_PRIVATE_FIELDS
 };
 
+/*
+ * Work kinds get separate queues in the threadpool so slow requests can't
+ * hold up quick ones.
+ */
+typedef enum {
+  UV_WORK_CPU = 0,
+  UV_WORK_FAST_IO,
+  UV_WORK_SLOW_IO,
+  UV_WORK_KIND_MAX
+} uv_work_kind;
+
 UV_EXTERN int uv_queue_work(uv_loop_t* loop,
                             uv_work_t* req,
                             uv_work_cb work_cb,
                             uv_after_work_cb after_work_cb);
+UV_EXTERN int uv_queue_work_ex(uv_loop_t* loop,
+                               uv_work_t* req,
+                               uv_work_kind kind,
+                               uv_work_cb work_cb,
+                               uv_after_work_cb after_work_cb);
+UV_EXTERN int uv_queue_work_many(uv_loop_t* loop,
+                                 uv_work_t* reqs,
+                                 unsigned int nreqs,
+                                 uv_work_kind kind,
+                                 uv_work_cb work_cb,
+                                 uv_after_work_cb after_work_cb);
+
+/*
+ * Requests submitted through a serial queue run one at a time, in the order
+ * they were submitted in, on whichever thread of the threadpool is free.
+ */
+struct uv_serial_s {
+  void* data;
+  uv_loop_t* loop;
+  UV_SERIAL_PRIVATE_FIELDS
+};
+
+UV_EXTERN int uv_serial_init(uv_loop_t* loop, uv_serial_t* serial);
+UV_EXTERN int uv_serial_destroy(uv_serial_t* serial);
+UV_EXTERN int uv_serial_queue_work(uv_serial_t* serial,
+                                   uv_work_t* req,
+                                   uv_work_cb work_cb,
+                                   uv_after_work_cb after_work_cb);
+
+UV_EXTERN int uv_threadpool_resize(unsigned int min_threads,
+                                   unsigned int max_threads);
+UV_EXTERN int uv_threadpool_setaffinity(const char* cpumask, size_t mask_size);
+
+/*
+ * Bucket i of a threadpool histogram counts times from 2^(i-1) up to 2^i
+ * microseconds, bucket 0 everything below a microsecond and the last bucket
+ * everything that doesn't fit into the others.
+ */
+#define UV_THREADPOOL_HISTOGRAM_SIZE 32
+
+typedef struct {
+  uint64_t submitted;
+  uint64_t completed;  /* Excludes cancelled requests. */
+  /* Only measured with uv_threadpool_stats_time(). */
+  uint64_t wait_time[UV_THREADPOOL_HISTOGRAM_SIZE];
+  uint64_t run_time[UV_THREADPOOL_HISTOGRAM_SIZE];
+} uv_threadpool_work_stats_t;
+
+typedef struct {
+  unsigned int nthreads;
+  unsigned int nidle;
+  unsigned int nqueued[UV_WORK_KIND_MAX];
+  uv_threadpool_work_stats_t work[UV_WORK_KIND_MAX];
+} uv_threadpool_stats_t;
+
+UV_EXTERN int uv_threadpool_stats(uv_threadpool_stats_t* stats);
+UV_EXTERN int uv_threadpool_stats_time(int enable);
 
 UV_EXTERN int uv_cancel(uv_req_t* req);
 
@@ -1251,6 +1409,42 @@ UV_EXTERN int uv_fs_fchown(uv_loop_t* loop,
                            uv_gid_t gid,
                            uv_fs_cb cb);
 
+/*
+ * Same as their uv_fs_*() counterparts, but the request waits its turn in
+ * `serial`, see uv_serial_queue_work(). Asynchronous only.
+ */
+UV_EXTERN int uv_serial_fs_read(uv_serial_t* serial,
+                                uv_fs_t* req,
+                                uv_file file,
+                                const uv_buf_t bufs[],
+                                unsigned int nbufs,
+                                int64_t offset,
+                                uv_fs_cb cb);
+UV_EXTERN int uv_serial_fs_write(uv_serial_t* serial,
+                                 uv_fs_t* req,
+                                 uv_file file,
+                                 const uv_buf_t bufs[],
+                                 unsigned int nbufs,
+                                 int64_t offset,
+                                 uv_fs_cb cb);
+UV_EXTERN int uv_serial_fs_fsync(uv_serial_t* serial,
+                                 uv_fs_t* req,
+                                 uv_file file,
+                                 uv_fs_cb cb);
+UV_EXTERN int uv_serial_fs_fdatasync(uv_serial_t* serial,
+                                     uv_fs_t* req,
+                                     uv_file file,
+                                     uv_fs_cb cb);
+UV_EXTERN int uv_serial_fs_ftruncate(uv_serial_t* serial,
+                                     uv_fs_t* req,
+                                     uv_file file,
+                                     int64_t offset,
+                                     uv_fs_cb cb);
+UV_EXTERN int uv_serial_fs_close(uv_serial_t* serial,
+                                 uv_fs_t* req,
+                                 uv_file file,
+                                 uv_fs_cb cb);
+
 
 enum uv_fs_event {
   UV_RENAME = 1,
@@ -1414,7 +1608,32 @@ UV_EXTERN void uv_key_set(uv_key_t* key, void* value);
 
 typedef void (*uv_thread_cb)(void* arg);
 
+typedef enum {
+  UV_THREAD_NO_FLAGS = 0x00,
+  UV_THREAD_HAS_STACK_SIZE = 0x01,
+  UV_THREAD_HAS_AFFINITY = 0x02,
+  UV_THREAD_HAS_NAME = 0x04
+} uv_thread_create_flags;
+
+struct uv_thread_options_s {
+  unsigned int flags;
+  size_t stack_size;
+  const char* cpumask;
+  size_t mask_size;
+  const char* name;
+};
+
+typedef struct uv_thread_options_s uv_thread_options_t;
+
 UV_EXTERN int uv_thread_create(uv_thread_t* tid, uv_thread_cb entry, void* arg);
+UV_EXTERN int uv_thread_create_ex(uv_thread_t* tid,
+                                  const uv_thread_options_t* params,
+                                  uv_thread_cb entry,
+                                  void* arg);
+UV_EXTERN int uv_thread_setaffinity(uv_thread_t* tid,
+                                    const char* cpumask,
+                                    size_t mask_size);
+UV_EXTERN int uv_cpumask_size(void);
 UV_EXTERN uv_thread_t uv_thread_self(void);
 UV_EXTERN int uv_thread_join(uv_thread_t *tid);
 UV_EXTERN int uv_thread_equal(const uv_thread_t* t1, const uv_thread_t* t2);
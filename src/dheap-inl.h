@@ -0,0 +1,209 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef UV_SRC_DHEAP_H_
+#define UV_SRC_DHEAP_H_
+
+#include "uv.h"
+#include "uv-common.h"
+
+#include <assert.h>
+#include <stddef.h>  /* NULL */
+
+#if defined(__GNUC__)
+# define DHEAP_EXPORT(declaration) __attribute__((unused)) static declaration
+#else
+# define DHEAP_EXPORT(declaration) static declaration
+#endif
+
+#define DHEAP_ARITY 4
+
+/* Remembers where in the heap the element is so it can be removed without
+ * searching for it.
+ */
+struct dheap_node {
+  unsigned int index;
+};
+
+/* The keys are copied into the heap array so comparisons never have to
+ * touch the element itself.  Ties on key are broken by seq.
+ */
+struct dheap_entry {
+  uint64_t key;
+  uint64_t seq;
+  struct dheap_node* node;
+};
+
+/* An array-backed 4-ary min heap.  A 4-ary heap is half as deep as a binary
+ * heap and the four children of a node are adjacent in memory, so sifting
+ * down compares keys that share a cache line or two instead of chasing
+ * pointers into a different handle for every comparison.
+ *
+ * The children of entry i are 4i+1 to 4i+4, its parent is (i-1)/4.
+ */
+struct dheap {
+  struct dheap_entry* entries;
+  unsigned int nelts;
+  unsigned int nalloc;
+};
+
+/* Return non-zero if a < b. */
+DHEAP_EXPORT(int dheap_less(const struct dheap_entry* a,
+                            const struct dheap_entry* b)) {
+  if (a->key != b->key)
+    return a->key < b->key;
+  return a->seq < b->seq;
+}
+
+DHEAP_EXPORT(void dheap_init(struct dheap* heap)) {
+  heap->entries = NULL;
+  heap->nelts = 0;
+  heap->nalloc = 0;
+}
+
+DHEAP_EXPORT(void dheap_free(struct dheap* heap)) {
+  uv__free(heap->entries);
+  dheap_init(heap);
+}
+
+DHEAP_EXPORT(struct dheap_node* dheap_min(const struct dheap* heap)) {
+  if (heap->nelts == 0)
+    return NULL;
+  return heap->entries[0].node;
+}
+
+DHEAP_EXPORT(void dheap_set(struct dheap* heap,
+                            unsigned int index,
+                            const struct dheap_entry* entry)) {
+  heap->entries[index] = *entry;
+  entry->node->index = index;
+}
+
+DHEAP_EXPORT(void dheap_sift_up(struct dheap* heap,
+                                unsigned int index,
+                                const struct dheap_entry* entry)) {
+  unsigned int parent;
+
+  while (index > 0) {
+    parent = (index - 1) / DHEAP_ARITY;
+    if (!dheap_less(entry, heap->entries + parent))
+      break;
+    dheap_set(heap, index, heap->entries + parent);
+    index = parent;
+  }
+
+  dheap_set(heap, index, entry);
+}
+
+DHEAP_EXPORT(void dheap_sift_down(struct dheap* heap,
+                                  unsigned int index,
+                                  const struct dheap_entry* entry)) {
+  unsigned int child;
+  unsigned int last;
+  unsigned int best;
+
+  for (;;) {
+    child = index * DHEAP_ARITY + 1;
+    if (child >= heap->nelts)
+      break;
+
+    last = child + DHEAP_ARITY;
+    if (last > heap->nelts)
+      last = heap->nelts;
+
+    for (best = child++; child < last; child++)
+      if (dheap_less(heap->entries + child, heap->entries + best))
+        best = child;
+
+    if (!dheap_less(heap->entries + best, entry))
+      break;
+
+    dheap_set(heap, index, heap->entries + best);
+    index = best;
+  }
+
+  dheap_set(heap, index, entry);
+}
+
+/* Makes room for `n` more elements, that many inserts can't fail after.
+ * Returns UV_ENOMEM if the array can't grow, the heap is unchanged then.
+ */
+DHEAP_EXPORT(int dheap_reserve(struct dheap* heap, unsigned int n)) {
+  struct dheap_entry* entries;
+  unsigned int nalloc;
+
+  if (heap->nalloc - heap->nelts >= n)
+    return 0;
+
+  nalloc = heap->nalloc ? heap->nalloc : 64;
+  while (nalloc - heap->nelts < n)
+    nalloc *= 2;
+
+  entries = uv__realloc(heap->entries, nalloc * sizeof(*entries));
+  if (entries == NULL)
+    return UV_ENOMEM;
+
+  heap->entries = entries;
+  heap->nalloc = nalloc;
+  return 0;
+}
+
+/* Returns UV_ENOMEM if the array can't grow, the heap is unchanged then. */
+DHEAP_EXPORT(int dheap_insert(struct dheap* heap,
+                              struct dheap_node* node,
+                              uint64_t key,
+                              uint64_t seq)) {
+  struct dheap_entry entry;
+  int err;
+
+  err = dheap_reserve(heap, 1);
+  if (err)
+    return err;
+
+  entry.key = key;
+  entry.seq = seq;
+  entry.node = node;
+  dheap_sift_up(heap, heap->nelts++, &entry);
+
+  return 0;
+}
+
+DHEAP_EXPORT(void dheap_remove(struct dheap* heap, struct dheap_node* node)) {
+  struct dheap_entry* last;
+  unsigned int index;
+
+  index = node->index;
+  assert(index < heap->nelts);
+  assert(heap->entries[index].node == node);
+
+  last = heap->entries + --heap->nelts;
+  if (index == heap->nelts)
+    return;
+
+  if (dheap_less(last, heap->entries + index))
+    dheap_sift_up(heap, index, last);
+  else
+    dheap_sift_down(heap, index, last);
+}
+
+#undef DHEAP_EXPORT
+
+#endif  /* UV_SRC_DHEAP_H_ */
@@ -23,6 +23,7 @@
 
 #if !defined(_WIN32)
 # include "unix/internal.h"
+# include "unix/atomic-ops.h"
 #else
 # include "win/req-inl.h"
 /* TODO(saghul): unify internal req functions */
@@ -35,21 +36,89 @@ static void uv__req_init(uv_loop_t* loop,
 }
 # define uv__req_init(loop, req, type) \
     uv__req_init((loop), (uv_req_t*)(req), (type))
+# define cmpxchgp(ptr, oldval, newval) \
+    InterlockedCompareExchangePointer((PVOID volatile*) (ptr), (newval), (oldval))
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 #define MAX_THREADPOOL_SIZE 128
 
+/* How many times an idle worker looks for work before it goes to sleep. */
+#define SPIN_ROUNDS 16
+
+/* In elastic mode, a worker is added when queued work has been waiting this
+ * long, and an idle worker above the minimum leaves after IDLE_TIMEOUT.
+ */
+#define SPAWN_THRESHOLD ((uint64_t) 5 * 1000 * 1000)
+#define IDLE_TIMEOUT ((uint64_t) 10 * 1000 * 1000 * 1000)
+
+/* Upper bound on the completions a worker holds back before it hands them
+ * to the loop.
+ */
+#define MAX_BATCH 32
+
+/* Completions of one loop, newest first. Finished requests link up through
+ * wq[1]. wq[0] keeps pointing at the request itself so uv_cancel() still sees
+ * an empty queue node.
+ */
+struct batch {
+  uv_loop_t* loop;
+  struct uv__work* head;
+  struct uv__work* tail;
+  unsigned int n;
+};
+
+/* Every worker owns a queue. Submissions are spread over the queues and a
+ * worker that runs out of work of its own steals from the others, so the
+ * common paths only ever take the lock of a single queue.
+ */
+struct worker {
+  uv_thread_t thread;
+  int started;  /* thread needs joining. */
+  uv_mutex_t mutex;  /* Protects queues and closed. */
+  QUEUE queues[UV_WORK_KIND_MAX];  /* One per uv_work_kind. */
+  /* Read without holding the lock to skip queues that look empty. Never
+   * lower than the real length, uv_cancel() doesn't bother to update it.
+   */
+  volatile unsigned int nqueued;
+  int closed;  /* No worker behind it, post() goes elsewhere. */
+  /* post() counts submissions with the lock held, everything else is only
+   * written by the worker's own thread. A new worker in the slot carries on
+   * where the last one left off.
+   */
+  uv_threadpool_work_stats_t stats[UV_WORK_KIND_MAX];
+};
+
 static uv_once_t once = UV_ONCE_INIT;
 static uv_cond_t cond;
-static uv_mutex_t mutex;
-static unsigned int nthreads;
-static uv_thread_t* threads;
-static uv_thread_t default_threads[4];
-static QUEUE exit_message;
-static QUEUE wq;
+static uv_mutex_t mutex;  /* Protects the pool state below. */
+static volatile unsigned int nidle;
+static unsigned int nwakeups;
+static int exiting;
+static unsigned int slow_io_running;
+static int slow_io_skipped;  /* take() left slow I/O in a queue. */
+static unsigned int min_threads;
+static unsigned int max_threads;
+static int spawning;
+static uv_mutex_t spawn_mutex;  /* Serializes spawn(). */
+static uv_cond_t manager_cond;
+static uv_thread_t manager_thread;
+static int manager_started;
+/* uv_hrtime() is too expensive to call on every submission when nobody
+ * looks at the result.
+ */
+static volatile int need_submit_time;
+static volatile int stats_time;
+/* Workers live in workers[0] to workers[nthreads - 1]. Only the last one may
+ * leave and new ones are added at the end.
+ */
+static volatile unsigned int nthreads;
+static struct worker workers[MAX_THREADPOOL_SIZE];
 static volatile int initialized;
+static char* affinity;
+static size_t affinity_size;
 
 
 static void uv__cancelled(struct uv__work* w) {
@@ -57,57 +126,699 @@ static void uv__cancelled(struct uv__work* w) {
 }
 
 
-/* To avoid deadlock with uv_cancel() it's crucial that the worker
- * never holds the global mutex and the loop-local mutex at the same time.
+static unsigned int histogram_bucket(uint64_t ns) {
+  unsigned int i;
+  uint64_t us;
+
+  us = ns / 1000;
+  for (i = 0; us != 0 && i < UV_THREADPOOL_HISTOGRAM_SIZE - 1; i++)
+    us >>= 1;
+
+  return i;
+}
+
+
+/* Quick requests go first so they don't wait behind slow ones. */
+static const uv_work_kind kind_order[] = {
+  UV_WORK_FAST_IO,
+  UV_WORK_CPU,
+  UV_WORK_SLOW_IO
+};
+
+
+/* Slow I/O may only occupy half of the workers, the other half stays
+ * available for everything else.
  */
-static void worker(void* arg) {
-  struct uv__work* w;
+static int slow_io_enter(void) {
+  int entered;
+
+  uv_mutex_lock(&mutex);
+  entered = slow_io_running < (nthreads + 1) / 2;
+  if (entered)
+    slow_io_running++;
+  else
+    slow_io_skipped = 1;
+  uv_mutex_unlock(&mutex);
+
+  return entered;
+}
+
+
+/* Slow I/O that was skipped because of the cap may be all that is left to
+ * do, with the workers that skipped it parked. Wake one of them.
+ */
+static void slow_io_leave(void) {
+  uv_mutex_lock(&mutex);
+  slow_io_running--;
+  if (slow_io_skipped && nwakeups < nidle) {
+    slow_io_skipped = 0;
+    nwakeups++;
+    uv_cond_signal(&cond);
+  }
+  uv_mutex_unlock(&mutex);
+}
+
+
+/* Hands out up to n wakeups, no more than there are parked workers to take
+ * them.
+ */
+static void wake(unsigned int n) {
+  uv_mutex_lock(&mutex);
+  for (; n > 0 && nwakeups < nidle; n--) {
+    nwakeups++;
+    uv_cond_signal(&cond);
+  }
+  uv_mutex_unlock(&mutex);
+}
+
+
+static QUEUE* take(struct worker* wk, uv_work_kind* kind) {
+  unsigned int nempty;
+  unsigned int i;
+  QUEUE* queue;
+  QUEUE* q;
+
+  uv_mutex_lock(&wk->mutex);
+
+  q = NULL;
+  nempty = 0;
+
+  for (i = 0; i < ARRAY_SIZE(kind_order); i++) {
+    queue = &wk->queues[kind_order[i]];
+
+    if (QUEUE_EMPTY(queue)) {
+      nempty++;
+      continue;
+    }
+
+    /* Whoever is running slow I/O looks again when it's done. */
+    if (kind_order[i] == UV_WORK_SLOW_IO && !slow_io_enter())
+      continue;
+
+    q = QUEUE_HEAD(queue);
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);  /* Signal uv_cancel() that the work req is
+                           executing. */
+    wk->nqueued--;
+    *kind = kind_order[i];
+    break;
+  }
+
+  if (nempty == ARRAY_SIZE(kind_order))
+    wk->nqueued = 0;
+
+  uv_mutex_unlock(&wk->mutex);
+
+  return q;
+}
+
+
+/* Tries the worker's own queue first, then the others. Unless `thorough` is
+ * set, queues that look empty are skipped without taking their lock.
+ */
+static QUEUE* find_work(unsigned int self, int thorough, uv_work_kind* kind) {
+  struct worker* wk;
+  unsigned int n;
+  unsigned int i;
+  QUEUE* q;
+
+  n = nthreads;
+
+  for (i = 0; i < n; i++) {
+    wk = workers + (self + i) % n;
+    if (!thorough && wk->nqueued == 0)
+      continue;
+    q = take(wk, kind);
+    if (q != NULL)
+      return q;
+  }
+
+  return NULL;
+}
+
+
+/* Called with the mutex held. */
+static int should_retire(unsigned int self, int timed_out) {
+  if (self != nthreads - 1 || spawning)
+    return 0;
+
+  if (nthreads > max_threads)
+    return 1;
+
+  return timed_out && nthreads > min_threads;
+}
+
+
+/* Called with the mutex held, returns non-zero on timeout. Workers above the
+ * minimum only wait so long.
+ */
+static int idle_wait(void) {
+  if (nthreads <= min_threads) {
+    uv_cond_wait(&cond, &mutex);
+    return 0;
+  }
+
+  return uv_cond_timedwait(&cond, &mutex, IDLE_TIMEOUT) == UV_ETIMEDOUT;
+}
+
+
+/* Sleeps until there is work. Returns NULL when the pool shuts down or the
+ * worker should leave.
+ *
+ * The worker counts itself as idle before it looks at the queues one last
+ * time. A post() that comes too late for that look is ordered after it by the
+ * queue's lock, sees the idle worker and hands out a wakeup.
+ */
+static QUEUE* park(unsigned int self, uv_work_kind* kind) {
+  int timed_out;
   QUEUE* q;
 
-  (void) arg;
+  uv_mutex_lock(&mutex);
+  nidle++;
+  uv_mutex_unlock(&mutex);
 
   for (;;) {
+    q = find_work(self, 1, kind);
+
     uv_mutex_lock(&mutex);
 
-    while (QUEUE_EMPTY(&wq))
-      uv_cond_wait(&cond, &mutex);
+    if (q != NULL || exiting)
+      break;
 
-    q = QUEUE_HEAD(&wq);
+    timed_out = 0;
+    while (nwakeups == 0 && !exiting && !should_retire(self, timed_out))
+      timed_out = idle_wait();
 
-    if (q == &exit_message)
-      uv_cond_signal(&cond);
-    else {
-      QUEUE_REMOVE(q);
-      QUEUE_INIT(q);  /* Signal uv_cancel() that the work req is
-                             executing. */
+    if (nwakeups == 0 && !exiting) {
+      nthreads--;
+      uv_cond_broadcast(&cond);  /* The next one may have to go too. */
+      break;
     }
 
+    if (nwakeups > 0)
+      nwakeups--;
+
     uv_mutex_unlock(&mutex);
+  }
+
+  /* Everyone is busy now, the manager keeps an eye on the wait times. */
+  if (--nidle == 0 && nthreads < max_threads)
+    uv_cond_signal(&manager_cond);
+
+  uv_mutex_unlock(&mutex);
+
+  return q;
+}
+
+
+/* A worker that leaves closes its queue and hands what is still in there
+ * to workers[0], which never leaves. The locks are taken in index order.
+ */
+static void close_queue(unsigned int self) {
+  struct worker* wk;
+  unsigned int moved;
+  unsigned int i;
+  QUEUE* q;
+
+  wk = workers + self;
+
+  uv_mutex_lock(&workers[0].mutex);
+  uv_mutex_lock(&wk->mutex);
+
+  for (i = 0; i < ARRAY_SIZE(wk->queues); i++) {
+    if (QUEUE_EMPTY(&wk->queues[i]))
+      continue;
+    QUEUE_FOREACH(q, &wk->queues[i])
+      QUEUE_DATA(q, struct uv__work, wq)->worker = 0;
+    QUEUE_ADD(&workers[0].queues[i], &wk->queues[i]);
+    QUEUE_INIT(&wk->queues[i]);
+  }
+
+  moved = wk->nqueued;
+  workers[0].nqueued += moved;
+  wk->nqueued = 0;
+  wk->closed = 1;
+
+  uv_mutex_unlock(&wk->mutex);
+  uv_mutex_unlock(&workers[0].mutex);
 
-    if (q == &exit_message)
+  if (moved > 0)
+    wake(1);
+}
+
+
+/* Pushes the batch onto the loop's list of finished requests with a single
+ * compare-and-swap and wakes up the loop, which picks it up in
+ * uv__work_done().
+ */
+static void flush(struct batch* b) {
+  void* head;
+  void* prev;
+
+  if (b->n == 0)
+    return;
+
+  head = b->loop->wq_completed;
+  for (;;) {
+    b->tail->wq[1] = head;
+    prev = cmpxchgp(&b->loop->wq_completed, head, b->head);
+    if (prev == head)
+      break;
+    head = prev;
+  }
+
+  uv_async_send(&b->loop->wq_async);
+
+  b->loop = NULL;
+  b->head = NULL;
+  b->tail = NULL;
+  b->n = 0;
+}
+
+
+static void batch_add(struct batch* b, struct uv__work* w) {
+  if (b->loop != w->loop)
+    flush(b);
+
+  if (b->n == 0) {
+    b->loop = w->loop;
+    b->tail = w;
+  }
+
+  w->wq[1] = b->head;
+  b->head = w;
+  b->n++;
+}
+
+
+/* A serial queue has one active request. It stays active after it ran until
+ * the loop has seen its completion, unless the worker that ran it moves the
+ * queue on to the next request right away. Returns that request, if any.
+ *
+ * The request goes to the queue of worker `self` next. It is marked as such
+ * before the serial queue's lock is released, that way uv_cancel() never
+ * looks at it with the wrong lock held.
+ */
+static struct uv__work* serial_next(uv_serial_t* serial, unsigned int self) {
+  struct uv__work* next;
+  QUEUE* q;
+
+  next = NULL;
+  uv_mutex_lock(&serial->mutex);
+
+  if (!QUEUE_EMPTY(&serial->queue)) {
+    q = QUEUE_HEAD(&serial->queue);
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);  /* Too late for uv_cancel(). */
+    next = QUEUE_DATA(q, struct uv__work, wq);
+    next->worker = self;
+    serial->active = next;
+  }
+
+  uv_mutex_unlock(&serial->mutex);
+
+  return next;
+}
+
+
+/* Queues the next request of a serial queue with the worker that ran the
+ * previous one. That worker most likely runs it next, other idle workers
+ * can still take it.
+ */
+static void post_next(unsigned int self, struct uv__work* w) {
+  struct worker* wk;
+  unsigned int idle;
+
+  wk = workers + self;
+  w->submit_time = need_submit_time ? uv_hrtime() : 0;
+
+  uv_mutex_lock(&wk->mutex);
+  QUEUE_INSERT_TAIL(&wk->queues[w->kind], &w->wq);
+  wk->nqueued++;
+  wk->stats[w->kind].submitted++;
+  idle = nidle;
+  uv_mutex_unlock(&wk->mutex);
+
+  if (idle != 0)
+    wake(1);
+}
+
+
+/* Completions are held back while the worker moves straight on to more fast
+ * I/O, which is quick by definition. Anything that may take a while, or
+ * having to wait for work, flushes them first.
+ */
+static void worker(void* arg) {
+  uv_threadpool_work_stats_t* stats;
+  struct uv__work* next;
+  struct uv__work* w;
+  struct batch b;
+  uv_work_kind kind;
+  uint64_t start;
+  unsigned int self;
+  unsigned int i;
+  QUEUE* q;
+
+  self = (unsigned int) (uintptr_t) arg;
+  memset(&b, 0, sizeof(b));
+
+  for (;;) {
+    q = find_work(self, 0, &kind);
+
+    if (q == NULL || kind != UV_WORK_FAST_IO || b.n >= MAX_BATCH)
+      flush(&b);
+
+    for (i = 1; q == NULL && i < SPIN_ROUNDS; i++)
+      q = find_work(self, 0, &kind);
+
+    if (q == NULL)
+      q = park(self, &kind);
+
+    if (q == NULL)
       break;
 
     w = QUEUE_DATA(q, struct uv__work, wq);
+    stats = workers[self].stats + kind;
+
+    start = 0;
+    if (stats_time) {
+      start = uv_hrtime();
+      /* Zero if it was queued before the clock was turned on. */
+      if (w->submit_time != 0)
+        stats->wait_time[histogram_bucket(start - w->submit_time)]++;
+    }
+
     w->work(w);
 
-    uv_mutex_lock(&w->loop->wq_mutex);
+    if (start != 0)
+      stats->run_time[histogram_bucket(uv_hrtime() - start)]++;
+    stats->completed++;
+
+    if (kind == UV_WORK_SLOW_IO)
+      slow_io_leave();
+
+    next = NULL;
+    if (w->serial != NULL)
+      next = serial_next(w->serial, self);
+
     w->work = NULL;  /* Signal uv_cancel() that the work req is done
                         executing. */
-    QUEUE_INSERT_TAIL(&w->loop->wq, &w->wq);
-    uv_async_send(&w->loop->wq_async);
-    uv_mutex_unlock(&w->loop->wq_mutex);
+    batch_add(&b, w);
+
+    /* The completion goes out first so the loop sees them in order. Once it
+     * has, the serial queue may be gone, only `next` is still safe to use.
+     */
+    if (next != NULL) {
+      flush(&b);
+      post_next(self, next);
+    }
+  }
+
+  if (self != 0)
+    close_queue(self);
+}
+
+
+static int start_worker(unsigned int slot) {
+  uv_thread_options_t options;
+  struct worker* wk;
+  void* arg;
+  int err;
+
+  wk = workers + slot;
+  arg = (void*) (uintptr_t) slot;
+
+  options.flags = UV_THREAD_HAS_NAME;
+  options.name = "libuv-worker";
+  if (affinity != NULL) {
+    options.flags |= UV_THREAD_HAS_AFFINITY;
+    options.cpumask = affinity;
+    options.mask_size = affinity_size;
+  }
+
+  err = uv_thread_create_ex(&wk->thread, &options, worker, arg);
+  if (err && affinity != NULL) {
+    /* A mask that names no online CPU makes pthread_create() fail. Start
+     * the worker unpinned, uv_threadpool_setaffinity() reports the error.
+     */
+    options.flags &= ~UV_THREAD_HAS_AFFINITY;
+    err = uv_thread_create_ex(&wk->thread, &options, worker, arg);
   }
+
+  if (err == 0)
+    wk->started = 1;
+
+  return err;
 }
 
 
-static void post(QUEUE* q) {
+/* Adds a worker at the end unless the pool is at its maximum. */
+static int spawn(void) {
+  struct worker* wk;
+  unsigned int slot;
+  int err;
+
+  uv_mutex_lock(&spawn_mutex);
+
+  uv_mutex_lock(&mutex);
+  if (exiting || nthreads >= max_threads) {
+    uv_mutex_unlock(&mutex);
+    uv_mutex_unlock(&spawn_mutex);
+    return 0;
+  }
+  spawning = 1;  /* Keeps the last worker from leaving meanwhile. */
+  slot = nthreads;
+  uv_mutex_unlock(&mutex);
+
+  wk = workers + slot;
+
+  /* The previous worker in this slot has left or is about to. */
+  if (wk->started) {
+    if (uv_thread_join(&wk->thread))
+      abort();
+    wk->started = 0;
+  }
+
+  uv_mutex_lock(&wk->mutex);
+  wk->closed = 0;
+  uv_mutex_unlock(&wk->mutex);
+
+  err = start_worker(slot);
+
   uv_mutex_lock(&mutex);
-  QUEUE_INSERT_TAIL(&wq, q);
-  uv_cond_signal(&cond);
+  if (err == 0)
+    nthreads++;
+  else
+    wk->closed = 1;
+  spawning = 0;
+  uv_mutex_unlock(&mutex);
+
+  uv_mutex_unlock(&spawn_mutex);
+
+  return err;
+}
+
+
+/* How long the oldest queued request has been waiting. */
+static uint64_t oldest_wait(void) {
+  struct uv__work* w;
+  struct worker* wk;
+  uint64_t oldest;
+  uint64_t now;
+  unsigned int n;
+  unsigned int i;
+  unsigned int k;
+
+  now = uv_hrtime();
+  oldest = now;
+  n = nthreads;
+
+  for (i = 0; i < n; i++) {
+    wk = workers + i;
+    if (wk->nqueued == 0)
+      continue;
+
+    uv_mutex_lock(&wk->mutex);
+    for (k = 0; k < ARRAY_SIZE(wk->queues); k++) {
+      if (QUEUE_EMPTY(&wk->queues[k]))
+        continue;
+      w = QUEUE_DATA(QUEUE_HEAD(&wk->queues[k]), struct uv__work, wq);
+      if (w->submit_time < oldest)
+        oldest = w->submit_time;
+    }
+    uv_mutex_unlock(&wk->mutex);
+  }
+
+  return now - oldest;
+}
+
+
+/* Only runs in elastic mode. While all workers are busy it checks every
+ * SPAWN_THRESHOLD whether queued work has been waiting too long.
+ */
+static void manager(void* arg) {
+  uv_mutex_lock(&mutex);
+
+  while (!exiting) {
+    if (nidle > 0 || nthreads >= max_threads) {
+      uv_cond_wait(&manager_cond, &mutex);
+      continue;
+    }
+
+    uv_cond_timedwait(&manager_cond, &mutex, SPAWN_THRESHOLD);
+
+    if (exiting || nidle > 0 || nthreads >= max_threads)
+      continue;
+
+    uv_mutex_unlock(&mutex);
+    if (oldest_wait() >= SPAWN_THRESHOLD)
+      spawn();
+    uv_mutex_lock(&mutex);
+  }
+
   uv_mutex_unlock(&mutex);
 }
 
 
+/* Every loop walks the queues round robin from a starting point of its own,
+ * so loops that submit at the same time mostly stay out of each other's way.
+ */
+static void post(uv_loop_t* loop, struct uv__work* w, uv_work_kind kind) {
+  struct worker* wk;
+  unsigned int idle;
+
+  w->submit_time = need_submit_time ? uv_hrtime() : 0;
+
+  for (;;) {
+    wk = workers + (loop->wq_slot++ + ((uintptr_t) loop >> 6)) % nthreads;
+    uv_mutex_lock(&wk->mutex);
+    if (!wk->closed)
+      break;
+    uv_mutex_unlock(&wk->mutex);  /* Its worker just left. */
+  }
+
+  QUEUE_INSERT_TAIL(&wk->queues[kind], &w->wq);
+  w->worker = wk - workers;
+  wk->nqueued++;
+  wk->stats[kind].submitted++;
+  idle = nidle;
+  uv_mutex_unlock(&wk->mutex);
+
+  if (idle == 0)
+    return;  /* Everyone is busy, the work gets picked up when one is done. */
+
+  wake(1);
+}
+
+
+/* Like post() for n requests at once. They are dealt out in chunks, one per
+ * queue, so every queue is locked at most once and a single trip through
+ * the global mutex wakes as many workers as there are requests.
+ */
+static void post_list(uv_loop_t* loop,
+                      QUEUE* list,
+                      unsigned int n,
+                      uv_work_kind kind) {
+  struct uv__work* w;
+  struct worker* wk;
+  unsigned int chunk;
+  unsigned int idle;
+  unsigned int nw;
+  unsigned int i;
+  uint64_t now;
+  QUEUE* q;
+
+  now = need_submit_time ? uv_hrtime() : 0;
+  nw = nthreads;
+  chunk = (n + nw - 1) / nw;
+  idle = 0;
+
+  while (!QUEUE_EMPTY(list)) {
+    wk = workers + (loop->wq_slot++ + ((uintptr_t) loop >> 6)) % nthreads;
+    uv_mutex_lock(&wk->mutex);
+    if (wk->closed) {
+      uv_mutex_unlock(&wk->mutex);  /* Its worker just left. */
+      continue;
+    }
+
+    for (i = 0; i < chunk && !QUEUE_EMPTY(list); i++) {
+      q = QUEUE_HEAD(list);
+      QUEUE_REMOVE(q);
+      w = QUEUE_DATA(q, struct uv__work, wq);
+      w->submit_time = now;
+      w->worker = wk - workers;
+      QUEUE_INSERT_TAIL(&wk->queues[kind], q);
+    }
+
+    wk->nqueued += i;
+    wk->stats[kind].submitted += i;
+    /* Same as in post(), every queue needs its own look at nidle. */
+    if (nidle != 0)
+      idle = 1;
+    uv_mutex_unlock(&wk->mutex);
+  }
+
+  if (idle == 0)
+    return;
+
+  wake(n);
+}
+
+
+/* Called on the loop thread. Runs the request right away if the serial queue
+ * is idle, otherwise it waits its turn in the serial queue.
+ */
+static void serial_submit(uv_serial_t* serial,
+                          struct uv__work* w,
+                          uv_work_kind kind) {
+  int idle;
+
+  w->serial = serial;
+  w->kind = kind;
+
+  uv_mutex_lock(&serial->mutex);
+  idle = (serial->active == NULL);
+  if (idle)
+    serial->active = w;
+  else
+    QUEUE_INSERT_TAIL(&serial->queue, &w->wq);
+  uv_mutex_unlock(&serial->mutex);
+
+  if (idle)
+    post(w->loop, w, kind);
+}
+
+
+/* Called on the loop thread before the completion callback of a request of
+ * a serial queue. If the request is still the active one, nobody moved the
+ * queue on yet.
+ */
+static void serial_done(struct uv__work* w) {
+  struct uv__work* next;
+  uv_serial_t* serial;
+  QUEUE* q;
+
+  serial = w->serial;
+  next = NULL;
+
+  uv_mutex_lock(&serial->mutex);
+
+  if (serial->active == w) {
+    if (!QUEUE_EMPTY(&serial->queue)) {
+      q = QUEUE_HEAD(&serial->queue);
+      QUEUE_REMOVE(q);
+      next = QUEUE_DATA(q, struct uv__work, wq);
+    }
+    serial->active = next;
+  }
+
+  uv_mutex_unlock(&serial->mutex);
+
+  if (next != NULL)
+    post(next->loop, next, next->kind);
+}
+
+
 #ifndef _WIN32
 UV_DESTRUCTOR(static void cleanup(void)) {
   unsigned int i;
@@ -115,20 +826,45 @@ UV_DESTRUCTOR(static void cleanup(void)) {
   if (initialized == 0)
     return;
 
-  post(&exit_message);
+  /* Workers finish what is queued before they see this. */
+  uv_mutex_lock(&mutex);
+  exiting = 1;
+  uv_cond_broadcast(&cond);
+  uv_cond_signal(&manager_cond);
+  uv_mutex_unlock(&mutex);
 
-  for (i = 0; i < nthreads; i++)
-    if (uv_thread_join(threads + i))
+  if (manager_started)
+    if (uv_thread_join(&manager_thread))
       abort();
 
-  if (threads != default_threads)
-    uv__free(threads);
+  for (i = 0; i < ARRAY_SIZE(workers); i++) {
+    if (workers[i].started)
+      if (uv_thread_join(&workers[i].thread))
+        abort();
+    workers[i].started = 0;
+  }
 
+  for (i = 0; i < ARRAY_SIZE(workers); i++)
+    uv_mutex_destroy(&workers[i].mutex);
+
+  uv__free(affinity);
+  affinity = NULL;
+  affinity_size = 0;
+
+  uv_mutex_destroy(&spawn_mutex);
   uv_mutex_destroy(&mutex);
+  uv_cond_destroy(&manager_cond);
   uv_cond_destroy(&cond);
 
-  threads = NULL;
   nthreads = 0;
+  nidle = 0;
+  nwakeups = 0;
+  slow_io_running = 0;
+  slow_io_skipped = 0;
+  manager_started = 0;
+  need_submit_time = 0;
+  stats_time = 0;
+  exiting = 0;
   initialized = 0;
 }
 #endif
@@ -136,58 +872,281 @@ UV_DESTRUCTOR(static void cleanup(void)) {
 
 static void init_once(void) {
   unsigned int i;
+  unsigned int j;
   const char* val;
 
-  nthreads = ARRAY_SIZE(default_threads);
+  min_threads = 4;
   val = getenv("UV_THREADPOOL_SIZE");
   if (val != NULL)
-    nthreads = atoi(val);
-  if (nthreads == 0)
-    nthreads = 1;
-  if (nthreads > MAX_THREADPOOL_SIZE)
-    nthreads = MAX_THREADPOOL_SIZE;
-
-  threads = default_threads;
-  if (nthreads > ARRAY_SIZE(default_threads)) {
-    threads = uv__malloc(nthreads * sizeof(threads[0]));
-    if (threads == NULL) {
-      nthreads = ARRAY_SIZE(default_threads);
-      threads = default_threads;
-    }
-  }
+    min_threads = atoi(val);
+  if (min_threads == 0)
+    min_threads = 1;
+  if (min_threads > MAX_THREADPOOL_SIZE)
+    min_threads = MAX_THREADPOOL_SIZE;
+  max_threads = min_threads;
 
   if (uv_cond_init(&cond))
     abort();
 
+  if (uv_cond_init(&manager_cond))
+    abort();
+
   if (uv_mutex_init(&mutex))
     abort();
 
-  QUEUE_INIT(&wq);
+  if (uv_mutex_init(&spawn_mutex))
+    abort();
 
-  for (i = 0; i < nthreads; i++)
-    if (uv_thread_create(threads + i, worker, NULL))
+  for (i = 0; i < ARRAY_SIZE(workers); i++) {
+    if (uv_mutex_init(&workers[i].mutex))
+      abort();
+    for (j = 0; j < ARRAY_SIZE(workers[i].queues); j++)
+      QUEUE_INIT(&workers[i].queues[j]);
+    workers[i].nqueued = 0;
+    workers[i].closed = 1;
+  }
+
+  for (i = 0; i < min_threads; i++)
+    if (spawn())
       abort();
 
   initialized = 1;
 }
 
 
+int uv_threadpool_resize(unsigned int min, unsigned int max) {
+  int need;
+  int err;
+
+  if (min == 0 || min > max || max > MAX_THREADPOOL_SIZE)
+    return UV_EINVAL;
+
+  uv_once(&once, init_once);
+
+  uv_mutex_lock(&mutex);
+
+  min_threads = min;
+  max_threads = max;
+
+  /* Workers above the new maximum leave as soon as they are idle. */
+  uv_cond_broadcast(&cond);
+
+  err = 0;
+  if (min < max && !manager_started) {
+    err = uv_thread_create(&manager_thread, manager, NULL);
+    manager_started = (err == 0);
+    need_submit_time = manager_started || stats_time;
+  }
+  uv_cond_signal(&manager_cond);
+
+  uv_mutex_unlock(&mutex);
+
+  if (err)
+    return err;
+
+  for (;;) {
+    uv_mutex_lock(&mutex);
+    need = nthreads < min_threads && !exiting;
+    uv_mutex_unlock(&mutex);
+
+    if (!need)
+      return 0;
+
+    err = spawn();
+    if (err)
+      return err;
+  }
+}
+
+
+int uv_threadpool_setaffinity(const char* cpumask, size_t mask_size) {
+  unsigned int i;
+  char* mask;
+  int err;
+
+  if (cpumask == NULL || mask_size == 0)
+    return UV_EINVAL;
+
+  if (uv_cpumask_size() < 0)
+    return uv_cpumask_size();
+
+  mask = uv__malloc(mask_size);
+  if (mask == NULL)
+    return UV_ENOMEM;
+
+  uv_once(&once, init_once);
+
+  /* Workers started from now on pick up the mask at creation time, the
+   * running ones are moved over.
+   */
+  uv_mutex_lock(&spawn_mutex);
+
+  memcpy(mask, cpumask, mask_size);
+  uv__free(affinity);
+  affinity = mask;
+  affinity_size = mask_size;
+
+  /* Holding the mutex keeps the workers from leaving meanwhile. */
+  uv_mutex_lock(&mutex);
+  err = 0;
+  for (i = 0; i < nthreads && err == 0; i++)
+    err = uv_thread_setaffinity(&workers[i].thread, affinity, affinity_size);
+  uv_mutex_unlock(&mutex);
+
+  uv_mutex_unlock(&spawn_mutex);
+
+  return err;
+}
+
+
+/* Workers may be halfway through updating their counters, so the numbers
+ * only roughly add up while requests are running.
+ */
+int uv_threadpool_stats(uv_threadpool_stats_t* stats) {
+  const uv_threadpool_work_stats_t* from;
+  uv_threadpool_work_stats_t* to;
+  struct worker* wk;
+  unsigned int i;
+  unsigned int k;
+  unsigned int j;
+  QUEUE* q;
+
+  if (stats == NULL)
+    return UV_EINVAL;
+
+  uv_once(&once, init_once);
+  memset(stats, 0, sizeof(*stats));
+
+  uv_mutex_lock(&mutex);
+  stats->nthreads = nthreads;
+  stats->nidle = nidle;
+  uv_mutex_unlock(&mutex);
+
+  /* Slots whose worker has left still hold its counters. */
+  for (i = 0; i < ARRAY_SIZE(workers); i++) {
+    wk = workers + i;
+    uv_mutex_lock(&wk->mutex);
+
+    for (k = 0; k < UV_WORK_KIND_MAX; k++) {
+      QUEUE_FOREACH(q, &wk->queues[k])
+        stats->nqueued[k]++;
+
+      from = wk->stats + k;
+      to = stats->work + k;
+      to->submitted += from->submitted;
+      to->completed += from->completed;
+      for (j = 0; j < UV_THREADPOOL_HISTOGRAM_SIZE; j++) {
+        to->wait_time[j] += from->wait_time[j];
+        to->run_time[j] += from->run_time[j];
+      }
+    }
+
+    uv_mutex_unlock(&wk->mutex);
+  }
+
+  return 0;
+}
+
+
+int uv_threadpool_stats_time(int enable) {
+  uv_once(&once, init_once);
+
+  uv_mutex_lock(&mutex);
+  stats_time = (enable != 0);
+  need_submit_time = manager_started || stats_time;
+  uv_mutex_unlock(&mutex);
+
+  return 0;
+}
+
+
 void uv__work_submit(uv_loop_t* loop,
                      struct uv__work* w,
+                     uv_work_kind kind,
                      void (*work)(struct uv__work* w),
                      void (*done)(struct uv__work* w, int status)) {
   uv_once(&once, init_once);
   w->loop = loop;
   w->work = work;
   w->done = done;
-  post(&w->wq);
+  w->serial = NULL;
+  w->worker = 0;
+  post(loop, w, kind);
+}
+
+
+/* Like uv__work_submit() for a request that waits its turn in `serial`. */
+void uv__work_submit_serial(uv_serial_t* serial,
+                            struct uv__work* w,
+                            uv_work_kind kind,
+                            void (*work)(struct uv__work* w),
+                            void (*done)(struct uv__work* w, int status)) {
+  uv_once(&once, init_once);
+  w->loop = serial->loop;
+  w->work = work;
+  w->done = done;
+  w->worker = 0;
+  serial_submit(serial, w, kind);
 }
 
 
+/* Submits the requests on `list`, linked through their wq fields, with fewer
+ * lock round trips than submitting them one by one. Leaves `list` empty.
+ */
+void uv__work_submit_list(uv_loop_t* loop,
+                          QUEUE* list,
+                          unsigned int n,
+                          uv_work_kind kind,
+                          void (*work)(struct uv__work* w),
+                          void (*done)(struct uv__work* w, int status)) {
+  struct uv__work* w;
+  QUEUE* q;
+
+  if (n == 0)
+    return;
+
+  uv_once(&once, init_once);
+
+  QUEUE_FOREACH(q, list) {
+    w = QUEUE_DATA(q, struct uv__work, wq);
+    w->loop = loop;
+    w->work = work;
+    w->done = done;
+    w->serial = NULL;
+    w->worker = 0;
+  }
+
+  post_list(loop, list, n, kind);
+}
+
+
+/* Only the queue the request was put in needs locking. A worker that leaves
+ * moves its requests to another queue, so check that it is still the right
+ * one once the lock is held. w->worker only changes with the lock of the old
+ * or, for a request of a serial queue, of the serial queue held.
+ */
 static int uv__work_cancel(uv_loop_t* loop, uv_req_t* req, struct uv__work* w) {
+  struct worker* wk;
   int cancelled;
 
-  uv_mutex_lock(&mutex);
+  /* Done, or never went through the threadpool in the first place. */
+  if (w->work == NULL)
+    return UV_EBUSY;
+
+  for (;;) {
+    wk = workers + w->worker;
+    uv_mutex_lock(&wk->mutex);
+    if (w->serial != NULL)
+      uv_mutex_lock(&w->serial->mutex);  /* It may be waiting in there. */
+
+    if (wk == workers + w->worker)
+      break;
+
+    if (w->serial != NULL)
+      uv_mutex_unlock(&w->serial->mutex);
+    uv_mutex_unlock(&wk->mutex);
+  }
+
   uv_mutex_lock(&w->loop->wq_mutex);
 
   cancelled = !QUEUE_EMPTY(&w->wq) && w->work != NULL;
@@ -195,7 +1154,9 @@ static int uv__work_cancel(uv_loop_t* loop, uv_req_t* req, struct uv__work* w) {
     QUEUE_REMOVE(&w->wq);
 
   uv_mutex_unlock(&w->loop->wq_mutex);
-  uv_mutex_unlock(&mutex);
+  if (w->serial != NULL)
+    uv_mutex_unlock(&w->serial->mutex);
+  uv_mutex_unlock(&wk->mutex);
 
   if (!cancelled)
     return UV_EBUSY;
@@ -211,15 +1172,19 @@ static int uv__work_cancel(uv_loop_t* loop, uv_req_t* req, struct uv__work* w) {
 
 
 void uv__work_done(uv_async_t* handle) {
+  struct uv__work* next;
+  struct uv__work* list;
   struct uv__work* w;
   uv_loop_t* loop;
+  void* head;
+  void* prev;
   QUEUE* q;
   QUEUE wq;
-  int err;
 
   loop = container_of(handle, uv_loop_t, wq_async);
   QUEUE_INIT(&wq);
 
+  /* Only cancelled requests come in through loop->wq. */
   uv_mutex_lock(&loop->wq_mutex);
   if (!QUEUE_EMPTY(&loop->wq)) {
     q = QUEUE_HEAD(&loop->wq);
@@ -232,8 +1197,33 @@ void uv__work_done(uv_async_t* handle) {
     QUEUE_REMOVE(q);
 
     w = container_of(q, struct uv__work, wq);
-    err = (w->work == uv__cancelled) ? UV_ECANCELED : 0;
-    w->done(w, err);
+    if (w->serial != NULL)
+      serial_done(w);
+    w->done(w, UV_ECANCELED);
+  }
+
+  /* Take all finished requests at once. They're newest first, reverse them
+   * so the callbacks run in the order the requests finished.
+   */
+  head = loop->wq_completed;
+  for (;;) {
+    prev = cmpxchgp(&loop->wq_completed, head, NULL);
+    if (prev == head)
+      break;
+    head = prev;
+  }
+
+  for (list = NULL, w = head; w != NULL; w = next) {
+    next = w->wq[1];
+    w->wq[1] = list;
+    list = w;
+  }
+
+  for (w = list; w != NULL; w = next) {
+    next = w->wq[1];
+    if (w->serial != NULL)
+      serial_done(w);
+    w->done(w, 0);
   }
 }
 
@@ -262,14 +1252,111 @@ int uv_queue_work(uv_loop_t* loop,
                   uv_work_t* req,
                   uv_work_cb work_cb,
                   uv_after_work_cb after_work_cb) {
+  return uv_queue_work_ex(loop, req, UV_WORK_CPU, work_cb, after_work_cb);
+}
+
+
+int uv_queue_work_ex(uv_loop_t* loop,
+                     uv_work_t* req,
+                     uv_work_kind kind,
+                     uv_work_cb work_cb,
+                     uv_after_work_cb after_work_cb) {
   if (work_cb == NULL)
     return UV_EINVAL;
 
+  if (kind < 0 || kind >= UV_WORK_KIND_MAX)
+    return UV_EINVAL;
+
   uv__req_init(loop, req, UV_WORK);
   req->loop = loop;
   req->work_cb = work_cb;
   req->after_work_cb = after_work_cb;
-  uv__work_submit(loop, &req->work_req, uv__queue_work, uv__queue_done);
+  uv__work_submit(loop, &req->work_req, kind, uv__queue_work, uv__queue_done);
+  return 0;
+}
+
+
+int uv_queue_work_many(uv_loop_t* loop,
+                       uv_work_t* reqs,
+                       unsigned int nreqs,
+                       uv_work_kind kind,
+                       uv_work_cb work_cb,
+                       uv_after_work_cb after_work_cb) {
+  unsigned int i;
+  QUEUE list;
+
+  if (work_cb == NULL)
+    return UV_EINVAL;
+
+  if (kind < 0 || kind >= UV_WORK_KIND_MAX)
+    return UV_EINVAL;
+
+  QUEUE_INIT(&list);
+
+  for (i = 0; i < nreqs; i++) {
+    uv__req_init(loop, reqs + i, UV_WORK);
+    reqs[i].loop = loop;
+    reqs[i].work_cb = work_cb;
+    reqs[i].after_work_cb = after_work_cb;
+    QUEUE_INSERT_TAIL(&list, &reqs[i].work_req.wq);
+  }
+
+  uv__work_submit_list(loop,
+                       &list,
+                       nreqs,
+                       kind,
+                       uv__queue_work,
+                       uv__queue_done);
+  return 0;
+}
+
+
+int uv_serial_init(uv_loop_t* loop, uv_serial_t* serial) {
+  int err;
+
+  err = uv_mutex_init(&serial->mutex);
+  if (err)
+    return err;
+
+  serial->loop = loop;
+  QUEUE_INIT(&serial->queue);
+  serial->active = NULL;
+
+  return 0;
+}
+
+
+int uv_serial_destroy(uv_serial_t* serial) {
+  int busy;
+
+  uv_mutex_lock(&serial->mutex);
+  busy = (serial->active != NULL);
+  uv_mutex_unlock(&serial->mutex);
+
+  if (busy)
+    return UV_EBUSY;
+
+  uv_mutex_destroy(&serial->mutex);
+  return 0;
+}
+
+
+int uv_serial_queue_work(uv_serial_t* serial,
+                         uv_work_t* req,
+                         uv_work_cb work_cb,
+                         uv_after_work_cb after_work_cb) {
+  if (work_cb == NULL)
+    return UV_EINVAL;
+
+  uv__req_init(serial->loop, req, UV_WORK);
+  req->loop = serial->loop;
+  req->work_cb = work_cb;
+  req->after_work_cb = after_work_cb;
+  uv__work_submit_serial(serial,
+                         &req->work_req,
+                         UV_WORK_CPU,
+                         uv__queue_work,
+                         uv__queue_done);
   return 0;
 }
 
@@ -282,6 +1369,10 @@ int uv_cancel(uv_req_t* req) {
   case UV_FS:
     loop =  ((uv_fs_t*) req)->loop;
     wreq = &((uv_fs_t*) req)->work_req;
+#if defined(__linux__)
+    if (wreq->work == NULL && loop->iou != NULL)
+      return uv__iou_fs_cancel(loop, (uv_fs_t*) req);
+#endif
     break;
   case UV_GETADDRINFO:
     loop =  ((uv_getaddrinfo_t*) req)->loop;
@@ -99,6 +99,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   uv__io_t* w;
   uint64_t base;
   uint64_t diff;
+  uint64_t idle_start;
   int nevents;
   int count;
   int nfds;
@@ -175,10 +176,12 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   count = 48; /* Benchmarks suggest this gives the best throughput. */
 
   for (;;) {
+    idle_start = uv__metrics_poll_start(loop, timeout);
     nfds = pollset_poll(loop->backend_fd,
                         events,
                         ARRAY_SIZE(events),
                         timeout);
+    SAVE_ERRNO(uv__metrics_poll_end(loop, idle_start));
 
     /* Update loop->time unconditionally. It's tempting to skip the update when
      * timeout == 0 (i.e. non-blocking poll) but there is no guarantee that the
@@ -242,6 +245,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
     loop->watchers[loop->nwatchers] = NULL;
     loop->watchers[loop->nwatchers + 1] = NULL;
+    uv__metrics_events(loop, nevents);
 
     if (nevents != 0) {
       if (nfds == ARRAY_SIZE(events) && --count != 0) {
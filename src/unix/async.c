@@ -49,29 +49,123 @@ int uv_async_init(uv_loop_t* loop, uv_async_t* handle, uv_async_cb async_cb) {
   uv__handle_init(loop, (uv_handle_t*)handle, UV_ASYNC);
   handle->async_cb = async_cb;
   handle->pending = 0;
+  handle->next_pending = NULL;
 
-  QUEUE_INSERT_TAIL(&loop->async_handles, &handle->queue);
+  QUEUE_INIT(&handle->queue);
   uv__handle_start(handle);
 
   return 0;
 }
 
 
+/* Lets another handle type share the loop's wakeup: `handle` is embedded in
+ * it and signaled with uv_async_send(), but it isn't a handle of its own.
+ * It isn't on the handle queue, doesn't keep the loop alive and is released
+ * with uv__async_close() instead of uv_close().
+ */
+int uv__async_attach(uv_loop_t* loop, uv_async_t* handle, uv_async_cb cb) {
+  int err;
+
+  err = uv__async_start(loop, &loop->async_watcher, uv__async_event);
+  if (err)
+    return err;
+
+  handle->loop = loop;
+  handle->type = UV_ASYNC;
+  handle->flags = 0;
+  handle->async_cb = cb;
+  handle->pending = 0;
+  handle->next_pending = NULL;
+  QUEUE_INIT(&handle->queue);
+
+  return 0;
+}
+
+
+/* Signaled handles are pushed onto loop->async_pending, a lock-free stack
+ * linked through next_pending.  Any thread can push but only the loop pops,
+ * and it always takes the whole stack at once, so there is no ABA problem.
+ * A handle is on the stack at most once: only the thread that flips pending
+ * from 0 to 1 pushes it, and the loop clears pending after it has unlinked
+ * the handle.
+ *
+ * The loop moves the handles it takes off the stack to loop->async_handles,
+ * in the order in which they were signaled.  There they wait for their
+ * callback and uv_close() can unlink them in constant time.
+ *
+ * A non-empty stack also means that a wakeup is pending: whoever pushed onto
+ * the empty stack has written or is about to write to the eventfd, and the
+ * loop reads the eventfd before it drains the stack.  Later senders skip the
+ * write() until the loop has emptied the stack again, no matter which handle
+ * they signal.  Returns non-zero if the stack was empty.
+ */
+static int uv__async_push(uv_loop_t* loop, uv_async_t* handle) {
+  void* head;
+
+  /* cmpxchgp() clobbers memory, no need for ACCESS_ONCE() to force a reload
+   * of the head.
+   */
+  do {
+    head = loop->async_pending;
+    handle->next_pending = head;
+  } while (cmpxchgp(&loop->async_pending, head, handle) != head);
+
+  return head == NULL;
+}
+
+
+static void uv__async_drain(uv_loop_t* loop) {
+  uv_async_t* next;
+  uv_async_t* prev;
+  uv_async_t* h;
+  void* head;
+
+  do
+    head = loop->async_pending;
+  while (head != NULL && cmpxchgp(&loop->async_pending, head, NULL) != head);
+
+  /* The stack is LIFO, reverse it. */
+  prev = NULL;
+  for (h = head; h != NULL; h = next) {
+    next = h->next_pending;
+    h->next_pending = prev;
+    prev = h;
+  }
+
+  for (h = prev; h != NULL; h = next) {
+    next = h->next_pending;
+    h->next_pending = NULL;
+    QUEUE_INSERT_TAIL(&loop->async_handles, &h->queue);
+  }
+}
+
+
 int uv_async_send(uv_async_t* handle) {
   /* Do a cheap read first. */
   if (ACCESS_ONCE(int, handle->pending) != 0)
     return 0;
 
   if (cmpxchgi(&handle->pending, 0, 1) == 0)
-    uv__async_send(&handle->loop->async_watcher);
+    if (uv__async_push(handle->loop, handle))
+      uv__async_send(&handle->loop->async_watcher);
 
   return 0;
 }
 
 
 void uv__async_close(uv_async_t* handle) {
-  QUEUE_REMOVE(&handle->queue);
   uv__handle_stop(handle);
+
+  if (ACCESS_ONCE(int, handle->pending) == 0)
+    return;
+
+  /* The handle's memory is about to be released, get it off the stack.
+   * Draining is cheap for the next handle that's closed, the stack is most
+   * likely empty by then.
+   */
+  uv__async_drain(handle->loop);
+  QUEUE_REMOVE(&handle->queue);
+  QUEUE_INIT(&handle->queue);
 }
 
 
@@ -81,11 +175,20 @@ static void uv__async_event(uv_loop_t* loop,
   QUEUE* q;
   uv_async_t* h;
 
-  QUEUE_FOREACH(q, &loop->async_handles) {
-    h = QUEUE_DATA(q, uv_async_t, queue);
+  /* Handles that are signaled again while the callbacks run stay on the stack
+   * until the next wakeup, unless uv_close() drains it.  That can happen only
+   * once per handle, so this loop terminates.
+   */
+  uv__async_drain(loop);
 
-    if (cmpxchgi(&h->pending, 1, 0) == 0)
-      continue;
+  while (!QUEUE_EMPTY(&loop->async_handles)) {
+    q = QUEUE_HEAD(&loop->async_handles);
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);
+
+    /* From here on uv_async_send() may push the handle again. */
+    h = QUEUE_DATA(q, uv_async_t, queue);
+    cmpxchgi(&h->pending, 1, 0);
 
     if (h->async_cb == NULL)
       continue;
@@ -235,7 +338,7 @@ void uv__async_stop(uv_loop_t* loop, struct uv__async* wa) {
     wa->wfd = -1;
   }
 
-  uv__io_stop(loop, &wa->io_watcher, UV__POLLIN);
+  uv__io_close(loop, &wa->io_watcher);
   uv__close(wa->io_watcher.fd);
   wa->io_watcher.fd = -1;
 }
@@ -20,6 +20,7 @@
 
 UV_UNUSED(static int cmpxchgi(int* ptr, int oldval, int newval));
 UV_UNUSED(static long cmpxchgl(long* ptr, long oldval, long newval));
+UV_UNUSED(static void* cmpxchgp(void** ptr, void* oldval, void* newval));
 UV_UNUSED(static void cpu_relax(void));
 
 /* Prefer hand-rolled assembly over the gcc builtins because the latter also
@@ -51,6 +52,11 @@ UV_UNUSED(static long cmpxchgl(long* ptr, long oldval, long newval)) {
 #endif
 }
 
+/* Pointers and longs have the same size on all supported unices. */
+UV_UNUSED(static void* cmpxchgp(void** ptr, void* oldval, void* newval)) {
+  return (void*) cmpxchgl((long*) ptr, (long) oldval, (long) newval);
+}
+
 UV_UNUSED(static void cpu_relax(void)) {
 #if defined(__i386__) || defined(__x86_64__)
   __asm__ __volatile__ ("rep; nop");  /* a.k.a. PAUSE */
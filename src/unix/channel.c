@@ -0,0 +1,180 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "internal.h"
+#include "atomic-ops.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+/* A bounded multi-producer, single-consumer ring.  Every slot carries a
+ * sequence number that says whose turn it is:
+ *
+ *   seq == pos             free, a producer may claim position pos
+ *   seq == pos + 1         filled, the loop may consume position pos
+ *   seq == pos + capacity  consumed, free again for the next lap
+ *
+ * Producers claim a position by bumping channel->tail, fill the slot and then
+ * publish it by bumping its seq.  Only the loop touches channel->head.
+ *
+ * Positions and sequence numbers are unsigned and wrap around, they are only
+ * ever compared through their difference.
+ *
+ * The seq updates and the acquiring reads on the loop side go through
+ * cmpxchgl() for its memory barrier, the compare itself never fails.
+ */
+struct uv__channel_slot {
+  unsigned long seq;
+  uv_channel_cb cb;
+  void* arg;
+};
+
+
+static unsigned long uv__channel_seq(struct uv__channel_slot* slot,
+                                     unsigned long oldval,
+                                     unsigned long newval) {
+  return cmpxchgl((long*) &slot->seq, (long) oldval, (long) newval);
+}
+
+
+/* Runs from the loop's async wakeup. */
+static void uv__channel_event(uv_async_t* handle) {
+  struct uv__channel_slot* slot;
+  uv_channel_t* channel;
+  uv_channel_cb cb;
+  unsigned long pos;
+  unsigned long n;
+  void* arg;
+
+  channel = container_of(handle, uv_channel_t, wakeup);
+
+  /* The wakeup is rearmed by now.  Everything that was published before
+   * fits in the ring, so one lap is enough.  Stopping there keeps fast
+   * producers from starving the rest of the loop.
+   */
+  for (n = 0; n <= channel->mask; n++) {
+    pos = channel->head;
+    slot = (struct uv__channel_slot*) channel->slots + (pos & channel->mask);
+
+    /* Empty, or a producer hasn't finished filling the slot yet.  It sends
+     * a wakeup when it has.
+     */
+    if (uv__channel_seq(slot, pos + 1, pos + 1) != pos + 1)
+      break;
+
+    cb = slot->cb;
+    arg = slot->arg;
+    uv__channel_seq(slot, pos + 1, pos + channel->mask + 1);
+    channel->head = pos + 1;
+
+    channel->loop->metrics.callbacks++;
+    cb(channel, arg);
+
+    if (uv__is_closing(channel))
+      break;
+  }
+}
+
+
+int uv_channel_init(uv_loop_t* loop,
+                    uv_channel_t* channel,
+                    unsigned int capacity) {
+  struct uv__channel_slot* slots;
+  unsigned int i;
+  int err;
+
+  /* With a single slot, "filled" (pos + 1) and "free for the next lap"
+   * (pos + capacity) are the same sequence number.
+   */
+  if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+    return -EINVAL;
+
+  slots = uv__malloc(capacity * sizeof(*slots));
+  if (slots == NULL)
+    return -ENOMEM;
+
+  for (i = 0; i < capacity; i++)
+    slots[i].seq = i;
+
+  /* Channels share the loop's wakeup with the uv_async_t handles. */
+  err = uv__async_attach(loop, &channel->wakeup, uv__channel_event);
+  if (err) {
+    uv__free(slots);
+    return err;
+  }
+
+  uv__handle_init(loop, (uv_handle_t*) channel, UV_CHANNEL);
+  channel->slots = slots;
+  channel->mask = capacity - 1;
+  channel->head = 0;
+  channel->tail = 0;
+  uv__handle_start(channel);
+
+  return 0;
+}
+
+
+int uv_channel_send(uv_channel_t* channel, uv_channel_cb cb, void* arg) {
+  struct uv__channel_slot* slot;
+  unsigned long prev;
+  unsigned long pos;
+  unsigned long seq;
+
+  if (cb == NULL)
+    return -EINVAL;
+
+  pos = ACCESS_ONCE(unsigned long, channel->tail);
+  for (;;) {
+    slot = (struct uv__channel_slot*) channel->slots + (pos & channel->mask);
+    seq = ACCESS_ONCE(unsigned long, slot->seq);
+
+    if (seq == pos) {
+      prev = cmpxchgl((long*) &channel->tail, (long) pos, (long) (pos + 1));
+      if (prev == pos)
+        break;
+      pos = prev;  /* Another producer got there first. */
+    } else if ((long) (seq - pos) < 0) {
+      return -EAGAIN;  /* The loop hasn't consumed this slot yet. */
+    } else {
+      pos = ACCESS_ONCE(unsigned long, channel->tail);
+    }
+  }
+
+  slot->cb = cb;
+  slot->arg = arg;
+  uv__channel_seq(slot, pos, pos + 1);
+
+  /* Only the first message after the loop looked at the ring writes to the
+   * eventfd, uv_async_send() skips it while the wakeup is pending.
+   */
+  uv_async_send(&channel->wakeup);
+
+  return 0;
+}
+
+
+void uv__channel_close(uv_channel_t* channel) {
+  uv__async_close(&channel->wakeup);
+  uv__free(channel->slots);
+  channel->slots = NULL;
+  uv__handle_stop(channel);
+}
@@ -42,6 +42,7 @@
 
 #ifdef __linux__
 # include <sys/ioctl.h>
+# include <linux/filter.h>  /* SO_ATTACH_REUSEPORT_CBPF */
 #endif
 
 #ifdef __sun
@@ -131,6 +132,10 @@ void uv_close(uv_handle_t* handle, uv_close_cb close_cb) {
     uv__async_close((uv_async_t*)handle);
     break;
 
+  case UV_CHANNEL:
+    uv__channel_close((uv_channel_t*)handle);
+    break;
+
   case UV_TIMER:
     uv__timer_close((uv_timer_t*)handle);
     break;
@@ -192,6 +197,92 @@ int uv__socket_sockopt(uv_handle_t* handle, int optname, int* value) {
   return 0;
 }
 
+
+static int uv__socket_fd(const uv_handle_t* handle, int* fd) {
+  if (handle->type == UV_TCP)
+    *fd = uv__stream_fd((uv_stream_t*) handle);
+  else if (handle->type == UV_UDP)
+    *fd = ((uv_udp_t*) handle)->io_watcher.fd;
+  else
+    return -ENOTSUP;
+
+  if (*fd == -1)
+    return -EBADF;
+
+  return 0;
+}
+
+
+int uv__sock_reuseport(int fd) {
+#if defined(SO_REUSEPORT)
+  int on;
+
+  on = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)))
+    return -errno;
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+int uv_incoming_cpu(uv_handle_t* handle, int cpu) {
+#if defined(SO_INCOMING_CPU)
+  int err;
+  int fd;
+
+  err = uv__socket_fd(handle, &fd);
+  if (err)
+    return err;
+
+  if (setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)))
+    return -errno;
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+/* Attach a classic BPF program to the SO_REUSEPORT group that returns the
+ * number of the CPU that received the packet, modulo the group size.  The
+ * kernel uses that as the index of the socket, i.e. the order of binding.
+ */
+int uv_reuseport_steer_cpu(uv_handle_t* handle, unsigned int nsockets) {
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+  struct sock_filter code[] = {
+    { BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+    { BPF_ALU | BPF_MOD | BPF_K, 0, 0, 0 },
+    { BPF_RET | BPF_A, 0, 0, 0 }
+  };
+  struct sock_fprog prog;
+  int err;
+  int fd;
+
+  if (nsockets == 0)
+    return -EINVAL;
+
+  err = uv__socket_fd(handle, &fd);
+  if (err)
+    return err;
+
+  code[1].k = nsockets;
+  prog.len = ARRAY_SIZE(code);
+  prog.filter = code;
+
+  if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)))
+    return -errno;
+
+  return 0;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
 void uv__make_close_pending(uv_handle_t* handle) {
   assert(handle->flags & UV_CLOSING);
   assert(!(handle->flags & UV_CLOSED));
@@ -216,6 +307,7 @@ static void uv__finish_close(uv_handle_t* handle) {
     case UV_CHECK:
     case UV_IDLE:
     case UV_ASYNC:
+    case UV_CHANNEL:
     case UV_TIMER:
     case UV_PROCESS:
     case UV_FS_EVENT:
@@ -243,6 +335,7 @@ static void uv__finish_close(uv_handle_t* handle) {
   QUEUE_REMOVE(&handle->handle_queue);
 
   if (handle->close_cb) {
+    handle->loop->metrics.callbacks++;
     handle->close_cb(handle);
   }
 }
@@ -289,10 +382,21 @@ int uv_backend_timeout(const uv_loop_t* loop) {
   if (loop->closing_handles)
     return 0;
 
+#if defined(__linux__)
+  if (!QUEUE_EMPTY(&loop->ready_queue))
+    return 0;
+#endif
+
   return uv__next_timeout(loop);
 }
 
 
+int uv_loop_metrics(const uv_loop_t* loop, uv_metrics_t* metrics) {
+  *metrics = loop->metrics;
+  return 0;
+}
+
+
 static int uv__loop_alive(const uv_loop_t* loop) {
   return uv__has_active_handles(loop) ||
          uv__has_active_reqs(loop) ||
@@ -306,6 +410,10 @@ int uv_loop_alive(const uv_loop_t* loop) {
 
 
 int uv_run(uv_loop_t* loop, uv_run_mode mode) {
+  uv_metrics_t* m;
+  uint64_t start;
+  uint64_t lap;
+  uint64_t idle;
   int timeout;
   int r;
   int ran_pending;
@@ -314,20 +422,34 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
   if (!r)
     uv__update_time(loop);
 
+  m = &loop->metrics;
+
   while (r != 0 && loop->stop_flag == 0) {
+    start = uv__metrics_now(loop);
+    lap = start;
+    m->loop_count++;
+
     uv__update_time(loop);
     uv__run_timers(loop);
+    uv__metrics_lap(loop, &m->timers_time, &lap);
     ran_pending = uv__run_pending(loop);
+    uv__metrics_lap(loop, &m->pending_time, &lap);
     uv__run_idle(loop);
     uv__run_prepare(loop);
+    uv__metrics_lap(loop, &m->prepare_time, &lap);
 
     timeout = 0;
     if ((mode == UV_RUN_ONCE && !ran_pending) || mode == UV_RUN_DEFAULT)
       timeout = uv_backend_timeout(loop);
 
+    idle = m->idle_time;
     uv__io_poll(loop, timeout);
+    uv__metrics_lap(loop, &m->poll_time, &lap);
+    m->poll_time -= m->idle_time - idle;
     uv__run_check(loop);
+    uv__metrics_lap(loop, &m->check_time, &lap);
     uv__run_closing_handles(loop);
+    uv__metrics_lap(loop, &m->closing_time, &lap);
 
     if (mode == UV_RUN_ONCE) {
       /* UV_RUN_ONCE implies forward progress: at least one callback must have
@@ -340,8 +462,18 @@ int uv_run(uv_loop_t* loop, uv_run_mode mode) {
        */
       uv__update_time(loop);
       uv__run_timers(loop);
+      uv__metrics_lap(loop, &m->timers_time, &lap);
     }
 
+    /* The time that the iteration kept the loop busy. */
+    if (loop->lag != NULL)
+      uv__lag_record(loop,
+                     UV_LAG_ITERATION,
+                     uv__hrtime(UV_CLOCK_PRECISE) - start -
+                         (m->idle_time - idle));
+
+    uv__metrics_lap(loop, &m->loop_time, &start);
+
     r = uv__loop_alive(loop);
     if (mode == UV_RUN_ONCE || mode == UV_RUN_NOWAIT)
       break;
@@ -715,6 +847,7 @@ static int uv__run_pending(uv_loop_t* loop) {
     QUEUE_REMOVE(q);
     QUEUE_INIT(q);
     w = QUEUE_DATA(q, uv__io_t, pending_queue);
+    loop->metrics.callbacks++;
     w->cb(loop, w, UV__POLLOUT);
   }
 
@@ -782,18 +915,65 @@ void uv__io_init(uv__io_t* w, uv__io_cb cb, int fd) {
   w->rcount = 0;
   w->wcount = 0;
 #endif /* defined(UV_HAVE_KQUEUE) */
+
+#if defined(__linux__)
+  QUEUE_INIT(&w->ready_queue);
+  w->ready = 0;
+  w->edge = 0;
+  w->unwanted = 0;
+  w->poll_id = 0;
+#endif /* defined(__linux__) */
 }
 
 
 void uv__io_start(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
+#if defined(__linux__)
+  unsigned int pevents;
+#endif
+
   assert(0 == (events & ~(UV__POLLIN | UV__POLLOUT)));
   assert(0 != events);
   assert(w->fd >= 0);
   assert(w->fd < INT_MAX);
 
+#if defined(__linux__)
+  pevents = w->pevents;
+#endif
   w->pevents |= events;
   maybe_resize(loop, w->fd + 1);
 
+#if defined(__linux__)
+  /* Edge-triggered watchers are registered for both directions once and
+   * stay registered until uv__io_close().  Changing the event mask doesn't
+   * need a system call but the fd may have become ready while we weren't
+   * looking.
+   */
+  if (w->events & UV__EPOLLET) {
+    assert(loop->watchers[w->fd] == w);
+    if (w->pevents != pevents)
+      loop->metrics.backend_ctl_saved++;
+    uv__io_check_ready(loop, w);
+    return;
+  }
+
+  /* The kernel's event mask is allowed to be a superset of w->pevents, see
+   * uv__io_stop().  Nothing to do if it already covers the new events.
+   */
+  if (w->events != 0 && (w->pevents & ~w->events) == 0) {
+    if (w->pevents != pevents)
+      loop->metrics.backend_ctl_saved++;
+    /* Wanted again, unwanted events reported before don't count any more. */
+    if (w->events == w->pevents) {
+      w->unwanted = 0;
+      if (!QUEUE_EMPTY(&w->watcher_queue)) {
+        QUEUE_REMOVE(&w->watcher_queue);
+        QUEUE_INIT(&w->watcher_queue);
+      }
+    }
+    return;
+  }
+#endif
+
 #if !defined(__sun)
   /* The event ports backend needs to rearm all file descriptors on each and
    * every tick of the event loop but the other backends allow us to
@@ -819,6 +999,10 @@ void uv__io_start(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
 
 void uv__io_stop(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
+#if defined(__linux__)
+  unsigned int pevents;
+#endif
+
   assert(0 == (events & ~(UV__POLLIN | UV__POLLOUT)));
   assert(0 != events);
 
@@ -831,8 +1015,23 @@ void uv__io_stop(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
   if ((unsigned) w->fd >= loop->nwatchers)
     return;
 
+#if defined(__linux__)
+  pevents = w->pevents;
+#endif
   w->pevents &= ~events;
 
+#if defined(__linux__)
+  if (w->events & UV__EPOLLET) {
+    if (w->pevents != pevents)
+      loop->metrics.backend_ctl_saved++;
+    if (w->pevents == 0) {
+      QUEUE_REMOVE(&w->ready_queue);
+      QUEUE_INIT(&w->ready_queue);
+    }
+    return;
+  }
+#endif
+
   if (w->pevents == 0) {
     QUEUE_REMOVE(&w->watcher_queue);
     QUEUE_INIT(&w->watcher_queue);
@@ -845,8 +1044,22 @@ void uv__io_stop(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
       w->events = 0;
     }
   }
-  else if (QUEUE_EMPTY(&w->watcher_queue))
+  else if (QUEUE_EMPTY(&w->watcher_queue)) {
+#if defined(__linux__)
+    /* Disarm lazily: leave the kernel's event mask alone and filter out the
+     * events we're no longer interested in after epoll_wait().  Many handles
+     * stop and restart the same direction on every tick, think of a stream
+     * that drains its write queue.  uv__io_poll() issues the EPOLL_CTL_MOD
+     * when the fd keeps reporting events that nobody wants.
+     */
+    if (w->events != 0) {
+      if (w->pevents != pevents)
+        loop->metrics.backend_ctl_saved++;
+      return;
+    }
+#endif
     QUEUE_INSERT_TAIL(&loop->watcher_queue, &w->watcher_queue);
+  }
 }
 
 
@@ -854,6 +1067,18 @@ void uv__io_close(uv_loop_t* loop, uv__io_t* w) {
   uv__io_stop(loop, w, UV__POLLIN | UV__POLLOUT);
   QUEUE_REMOVE(&w->pending_queue);
 
+#if defined(__linux__)
+  if (w->events & UV__EPOLLET) {
+    assert(loop->watchers[w->fd] == w);
+    assert(loop->nfds > 0);
+    loop->watchers[w->fd] = NULL;
+    loop->nfds--;
+    w->events = 0;
+  }
+  w->ready = 0;
+  uv__iou_poll_cancel(loop, w);
+#endif
+
   /* Remove stale events for this file descriptor */
   uv__platform_invalidate_fd(loop, w->fd);
 }
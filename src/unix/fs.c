@@ -68,6 +68,7 @@
     (req)->path = NULL;                                                       \
     (req)->new_path = NULL;                                                   \
     (req)->cb = (cb);                                                         \
+    (req)->work_req.serial = NULL;                                            \
   }                                                                           \
   while (0)
 
@@ -94,10 +95,45 @@
   }                                                                           \
   while (0)
 
+#define BUFS                                                                  \
+  do {                                                                        \
+    (req)->nbufs = (nbufs);                                                   \
+    (req)->bufs = (req)->bufsml;                                              \
+    if ((nbufs) > ARRAY_SIZE((req)->bufsml))                                  \
+      (req)->bufs = uv__malloc((nbufs) * sizeof(*(bufs)));                    \
+    if ((req)->bufs == NULL)                                                  \
+      return -ENOMEM;                                                         \
+    memcpy((req)->bufs, (bufs), (nbufs) * sizeof(*(bufs)));                   \
+  }                                                                           \
+  while (0)
+
+#if defined(__linux__)
+# define uv__fs_iou_submit(loop, req) uv__iou_fs_submit((loop), (req))
+#else
+# define uv__fs_iou_submit(loop, req) 0
+#endif
+
+/* Requests for a serial queue skip io_uring, the ring doesn't keep them in
+ * order.
+ */
 #define POST                                                                  \
   do {                                                                        \
     if ((cb) != NULL) {                                                       \
-      uv__work_submit((loop), &(req)->work_req, uv__fs_work, uv__fs_done);    \
+      if ((req)->work_req.serial != NULL) {                                   \
+        uv__work_submit_serial((req)->work_req.serial,                        \
+                               &(req)->work_req,                              \
+                               UV_WORK_FAST_IO,                               \
+                               uv__fs_work,                                   \
+                               uv__fs_done);                                  \
+        return 0;                                                             \
+      }                                                                       \
+      if (uv__fs_iou_submit((loop), (req)))                                   \
+        return 0;                                                             \
+      uv__work_submit((loop),                                                 \
+                      &(req)->work_req,                                       \
+                      UV_WORK_FAST_IO,                                        \
+                      uv__fs_work,                                            \
+                      uv__fs_done);                                           \
       return 0;                                                               \
     }                                                                         \
     else {                                                                    \
@@ -1037,17 +1073,7 @@ int uv_fs_read(uv_loop_t* loop, uv_fs_t* req,
                uv_fs_cb cb) {
   INIT(READ);
   req->file = file;
-
-  req->nbufs = nbufs;
-  req->bufs = req->bufsml;
-  if (nbufs > ARRAY_SIZE(req->bufsml))
-    req->bufs = uv__malloc(nbufs * sizeof(*bufs));
-
-  if (req->bufs == NULL)
-    return -ENOMEM;
-
-  memcpy(req->bufs, bufs, nbufs * sizeof(*bufs));
-
+  BUFS;
   req->off = off;
   POST;
 }
@@ -1159,22 +1185,126 @@ int uv_fs_write(uv_loop_t* loop,
                 uv_fs_cb cb) {
   INIT(WRITE);
   req->file = file;
+  BUFS;
+  req->off = off;
+  POST;
+}
+
+
+int uv_serial_fs_read(uv_serial_t* serial,
+                      uv_fs_t* req,
+                      uv_file file,
+                      const uv_buf_t bufs[],
+                      unsigned int nbufs,
+                      int64_t off,
+                      uv_fs_cb cb) {
+  uv_loop_t* loop;
+
+  if (cb == NULL)
+    return -EINVAL;
+
+  loop = serial->loop;
+  INIT(READ);
+  req->work_req.serial = serial;
+  req->file = file;
+  BUFS;
+  req->off = off;
+  POST;
+}
 
-  req->nbufs = nbufs;
-  req->bufs = req->bufsml;
-  if (nbufs > ARRAY_SIZE(req->bufsml))
-    req->bufs = uv__malloc(nbufs * sizeof(*bufs));
 
-  if (req->bufs == NULL)
-    return -ENOMEM;
+int uv_serial_fs_write(uv_serial_t* serial,
+                       uv_fs_t* req,
+                       uv_file file,
+                       const uv_buf_t bufs[],
+                       unsigned int nbufs,
+                       int64_t off,
+                       uv_fs_cb cb) {
+  uv_loop_t* loop;
 
-  memcpy(req->bufs, bufs, nbufs * sizeof(*bufs));
+  if (cb == NULL)
+    return -EINVAL;
 
+  loop = serial->loop;
+  INIT(WRITE);
+  req->work_req.serial = serial;
+  req->file = file;
+  BUFS;
   req->off = off;
   POST;
 }
 
 
+int uv_serial_fs_fsync(uv_serial_t* serial,
+                       uv_fs_t* req,
+                       uv_file file,
+                       uv_fs_cb cb) {
+  uv_loop_t* loop;
+
+  if (cb == NULL)
+    return -EINVAL;
+
+  loop = serial->loop;
+  INIT(FSYNC);
+  req->work_req.serial = serial;
+  req->file = file;
+  POST;
+}
+
+
+int uv_serial_fs_fdatasync(uv_serial_t* serial,
+                           uv_fs_t* req,
+                           uv_file file,
+                           uv_fs_cb cb) {
+  uv_loop_t* loop;
+
+  if (cb == NULL)
+    return -EINVAL;
+
+  loop = serial->loop;
+  INIT(FDATASYNC);
+  req->work_req.serial = serial;
+  req->file = file;
+  POST;
+}
+
+
+int uv_serial_fs_ftruncate(uv_serial_t* serial,
+                           uv_fs_t* req,
+                           uv_file file,
+                           int64_t off,
+                           uv_fs_cb cb) {
+  uv_loop_t* loop;
+
+  if (cb == NULL)
+    return -EINVAL;
+
+  loop = serial->loop;
+  INIT(FTRUNCATE);
+  req->work_req.serial = serial;
+  req->file = file;
+  req->off = off;
+  POST;
+}
+
+
+int uv_serial_fs_close(uv_serial_t* serial,
+                       uv_fs_t* req,
+                       uv_file file,
+                       uv_fs_cb cb) {
+  uv_loop_t* loop;
+
+  if (cb == NULL)
+    return -EINVAL;
+
+  loop = serial->loop;
+  INIT(CLOSE);
+  req->work_req.serial = serial;
+  req->file = file;
+  POST;
+}
+
+
 void uv_fs_req_cleanup(uv_fs_t* req) {
   uv__free((void*)req->path);
   req->path = NULL;
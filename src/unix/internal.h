@@ -144,12 +144,18 @@ enum {
   UV_TCP_KEEPALIVE        = 0x800,  /* Turn on keep-alive. */
   UV_TCP_SINGLE_ACCEPT    = 0x1000, /* Only accept() when idle. */
   UV_HANDLE_IPV6          = 0x10000, /* Handle is bound to a IPv6 socket. */
-  UV_UDP_PROCESSING       = 0x20000  /* Handle is running the send callback queue. */
+  UV_UDP_PROCESSING       = 0x20000, /* Handle is running the send callback queue. */
+  UV_TIMER_NS             = 0x40000  /* Started with uv_timer_start_ns(). */
 };
 
 /* loop flags */
 enum {
-  UV_LOOP_BLOCK_SIGPROF = 1
+  UV_LOOP_BLOCK_SIGPROF = 1,
+  UV_LOOP_EPOLLET = 2,
+  UV_LOOP_POLL_ADAPTIVE = 4,
+  UV_LOOP_PHASE_TIMES = 8,
+  UV_LOOP_CLOCK_PRECISE = 16,
+  UV_LOOP_CLOCK_TSC = 32
 };
 
 typedef enum {
@@ -170,6 +176,7 @@ int uv__close(int fd);
 int uv__cloexec(int fd, int set);
 int uv__socket(int domain, int type, int protocol);
 int uv__dup(int fd);
+int uv__sock_reuseport(int fd);
 ssize_t uv__recvmsg(int fd, struct msghdr *msg, int flags);
 void uv__make_close_pending(uv_handle_t* handle);
 
@@ -186,11 +193,15 @@ void uv__async_send(struct uv__async* wa);
 void uv__async_init(struct uv__async* wa);
 int uv__async_start(uv_loop_t* loop, struct uv__async* wa, uv__async_cb cb);
 void uv__async_stop(uv_loop_t* loop, struct uv__async* wa);
+int uv__async_attach(uv_loop_t* loop, uv_async_t* handle, uv_async_cb cb);
 
 /* loop */
 void uv__run_idle(uv_loop_t* loop);
 void uv__run_check(uv_loop_t* loop);
 void uv__run_prepare(uv_loop_t* loop);
+int uv__lag_init(uv_loop_t* loop);
+void uv__lag_delete(uv_loop_t* loop);
+void uv__lag_record(uv_loop_t* loop, uv_lag_type type, uint64_t value);
 
 /* stream */
 void uv__stream_init(uv_loop_t* loop, uv_stream_t* stream,
@@ -216,6 +227,17 @@ int uv_pipe_listen(uv_pipe_t* handle, int backlog, uv_connection_cb cb);
 /* timer */
 void uv__run_timers(uv_loop_t* loop);
 int uv__next_timeout(const uv_loop_t* loop);
+#if defined(__linux__)
+void uv__run_hrtimers(uv_loop_t* loop);
+#endif
+
+/* timer-wheel */
+int uv__timer_wheel_init(uv_loop_t* loop);
+void uv__timer_wheel_delete(uv_loop_t* loop);
+void uv__timer_wheel_insert(uv_loop_t* loop, uv_timer_t* handle);
+void uv__timer_wheel_remove(uv_loop_t* loop, uv_timer_t* handle);
+uv_timer_t* uv__timer_wheel_due(uv_loop_t* loop);
+int uv__timer_wheel_next(const uv_loop_t* loop, uint64_t* timeout);
 
 /* signal */
 void uv__signal_close(uv_signal_t* handle);
@@ -228,9 +250,24 @@ int uv__kqueue_init(uv_loop_t* loop);
 int uv__platform_loop_init(uv_loop_t* loop);
 void uv__platform_loop_delete(uv_loop_t* loop);
 void uv__platform_invalidate_fd(uv_loop_t* loop, int fd);
+#if defined(__linux__)
+void uv__io_check_ready(uv_loop_t* loop, uv__io_t* w);
+uint64_t uv__busy_poll_end(uv_loop_t* loop, int timeout);
+int uv__io_poll_batch(uv_loop_t* loop, int size, int budget);
+int uv__hrtimer_arm(uv_loop_t* loop, uint64_t due);
+int uv__tsc_init(uv_loop_t* loop);
+uint64_t uv__tsc_now(uv_loop_t* loop);
+int uv__iou_init(uv_loop_t* loop);
+void uv__iou_delete(uv_loop_t* loop);
+void uv__iou_poll(uv_loop_t* loop, int timeout);
+void uv__iou_poll_cancel(uv_loop_t* loop, uv__io_t* w);
+int uv__iou_fs_submit(uv_loop_t* loop, uv_fs_t* req);
+int uv__iou_fs_cancel(uv_loop_t* loop, uv_fs_t* req);
+#endif
 
 /* various */
 void uv__async_close(uv_async_t* handle);
+void uv__channel_close(uv_channel_t* handle);
 void uv__check_close(uv_check_t* handle);
 void uv__fs_event_close(uv_fs_event_t* handle);
 void uv__idle_close(uv_idle_t* handle);
@@ -297,9 +334,87 @@ UV_UNUSED(static void uv__req_init(uv_loop_t* loop,
   uv__req_init((loop), (uv_req_t*)(req), (type))
 
 UV_UNUSED(static void uv__update_time(uv_loop_t* loop)) {
-  /* Use a fast time source if available.  We only need millisecond precision.
+  uint64_t now;
+
+  /* Use a fast time source if available.  We only need millisecond precision,
+   * unless the user asked for more with UV_LOOP_CLOCK_MODE.
    */
-  loop->time = uv__hrtime(UV_CLOCK_FAST) / 1000000;
+  if (loop->flags & UV_LOOP_CLOCK_PRECISE)
+    now = uv__hrtime(UV_CLOCK_PRECISE);
+#if defined(__linux__)
+  else if (loop->flags & UV_LOOP_CLOCK_TSC)
+    now = uv__tsc_now(loop);
+#endif
+  else
+    now = uv__hrtime(UV_CLOCK_FAST);
+
+  /* The clocks are up to a tick of CLOCK_MONOTONIC_COARSE apart.  Don't let
+   * the loop time go backwards after a switch with UV_LOOP_CLOCK_MODE.
+   */
+  if (now > loop->time_ns) {
+    loop->time_ns = now;
+    loop->time = now / 1000000;
+  }
+}
+
+UV_UNUSED(static uint64_t uv__metrics_now(const uv_loop_t* loop)) {
+  if ((loop->flags & UV_LOOP_PHASE_TIMES) || loop->lag != NULL)
+    return uv__hrtime(UV_CLOCK_PRECISE);
+  return 0;
+}
+
+/* Adds the time since *start to *time and starts the next lap. */
+UV_UNUSED(static void uv__metrics_lap(uv_loop_t* loop,
+                                      uint64_t* time,
+                                      uint64_t* start)) {
+  uint64_t now;
+
+  if (!(loop->flags & UV_LOOP_PHASE_TIMES))
+    return;
+
+  now = uv__hrtime(UV_CLOCK_PRECISE);
+  *time += now - *start;
+  *start = now;
+}
+
+/* Call before and after the backend's wait for events.  Only a blocking wait
+ * counts as idle time.
+ */
+UV_UNUSED(static uint64_t uv__metrics_poll_start(const uv_loop_t* loop,
+                                                 int timeout)) {
+  if (timeout == 0)
+    return 0;
+  return uv__metrics_now(loop);
+}
+
+UV_UNUSED(static void uv__metrics_poll_end(uv_loop_t* loop, uint64_t start)) {
+  loop->metrics.polls++;
+  if (start != 0)
+    loop->metrics.idle_time += uv__hrtime(UV_CLOCK_PRECISE) - start;
+}
+
+UV_UNUSED(static void uv__metrics_events(uv_loop_t* loop, int nevents)) {
+  loop->metrics.events += nevents;
+  loop->metrics.callbacks += nevents;
+}
+
+UV_UNUSED(static void uv__io_allow_edge(uv__io_t* w)) {
+  /* The owner promises to read or write until EAGAIN and to report that with
+   * uv__io_drained(). Only such watchers are registered with EPOLLET when
+   * the loop is configured with UV_LOOP_EDGE_TRIGGERED.
+   */
+#if defined(__linux__)
+  w->edge = 1;
+#endif
+}
+
+UV_UNUSED(static void uv__io_drained(uv__io_t* w, unsigned int events)) {
+  /* The kernel won't report the fd again until the next edge. A pending
+   * socket error is consumed by the same read() or write() call.
+   */
+#if defined(__linux__)
+  w->ready &= ~(events | UV__POLLERR);
+#endif
 }
 
 UV_UNUSED(static char* uv__basename_r(const char* path)) {
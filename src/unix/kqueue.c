@@ -60,6 +60,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   sigset_t set;
   uint64_t base;
   uint64_t diff;
+  uint64_t idle_start;
   int filter;
   int fflags;
   int count;
@@ -136,6 +137,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       spec.tv_nsec = (timeout % 1000) * 1000000;
     }
 
+    idle_start = uv__metrics_poll_start(loop, timeout);
+
     if (pset != NULL)
       pthread_sigmask(SIG_BLOCK, pset, NULL);
 
@@ -149,6 +152,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (pset != NULL)
       pthread_sigmask(SIG_UNBLOCK, pset, NULL);
 
+    SAVE_ERRNO(uv__metrics_poll_end(loop, idle_start));
+
     /* Update loop->time unconditionally. It's tempting to skip the update when
      * timeout == 0 (i.e. non-blocking poll) but there is no guarantee that the
      * operating system didn't reschedule our process while in the syscall.
@@ -249,6 +254,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     }
     loop->watchers[loop->nwatchers] = NULL;
     loop->watchers[loop->nwatchers + 1] = NULL;
+    uv__metrics_events(loop, nevents);
 
     if (nevents != 0) {
       if (nfds == ARRAY_SIZE(events) && --count != 0) {
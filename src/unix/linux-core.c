@@ -20,6 +20,7 @@
 
 #include "uv.h"
 #include "internal.h"
+#include "dheap-inl.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -68,10 +69,28 @@
 # define CLOCK_BOOTTIME 7
 #endif
 
+/* How often a lazily disarmed watcher may report events it no longer wants
+ * before uv__io_poll() updates the kernel's event mask after all.
+ */
+#define UV__EPOLL_UNWANTED_MAX 2
+
+/* Bounds for the number of events that uv__io_poll() fetches at once.  In
+ * adaptive mode the buffer shrinks after UV__POLL_SHRINK_AFTER polls in a
+ * row that used less than a quarter of it.
+ */
+#define UV__POLL_BATCH_DEFAULT 1024
+#define UV__POLL_BATCH_MIN 64
+#define UV__POLL_BATCH_MAX 65536
+#define UV__POLL_SHRINK_AFTER 64
+
+/* Benchmarks suggest this gives the best throughput. */
+#define UV__POLL_BUDGET_DEFAULT 48
+
 static int read_models(unsigned int numcpus, uv_cpu_info_t* ci);
 static int read_times(unsigned int numcpus, uv_cpu_info_t* ci);
 static void read_speeds(unsigned int numcpus, uv_cpu_info_t* ci);
 static unsigned long read_cpufreq(unsigned int cpunum);
+static void uv__hrtimer_io(uv_loop_t* loop, uv__io_t* w, unsigned int events);
 
 
 int uv__platform_loop_init(uv_loop_t* loop) {
@@ -92,15 +111,45 @@ int uv__platform_loop_init(uv_loop_t* loop) {
   loop->backend_fd = fd;
   loop->inotify_fd = -1;
   loop->inotify_watchers = NULL;
+  QUEUE_INIT(&loop->ready_queue);
+  loop->iou = NULL;
+  loop->busy_poll = 0;
+  loop->poll_batch = UV__POLL_BATCH_DEFAULT;
+  loop->poll_budget = UV__POLL_BUDGET_DEFAULT;
+  loop->poll_streak = 0;
+  loop->poll_nevents = 0;
+  loop->poll_events = NULL;
+  uv__io_init(&loop->hrtimer_watcher, uv__hrtimer_io, -1);
+  dheap_init((struct dheap*) &loop->hrtimer_heap);
+  loop->hrtimer_armed = 0;
 
   if (fd == -1)
     return -errno;
 
+  loop->poll_events = uv__malloc(UV__POLL_BATCH_DEFAULT *
+                                 sizeof(struct uv__epoll_event));
+  if (loop->poll_events == NULL) {
+    uv__close(fd);
+    loop->backend_fd = -1;
+    return -ENOMEM;
+  }
+  loop->poll_nevents = UV__POLL_BATCH_DEFAULT;
+
   return 0;
 }
 
 
 void uv__platform_loop_delete(uv_loop_t* loop) {
+  uv__iou_delete(loop);
+  uv__free(loop->poll_events);
+  loop->poll_events = NULL;
+  loop->poll_nevents = 0;
+  if (loop->hrtimer_watcher.fd != -1) {
+    uv__io_stop(loop, &loop->hrtimer_watcher, UV__POLLIN);
+    uv__close(loop->hrtimer_watcher.fd);
+    loop->hrtimer_watcher.fd = -1;
+  }
+  dheap_free((struct dheap*) &loop->hrtimer_heap);
   if (loop->inotify_fd == -1) return;
   uv__io_stop(loop, &loop->inotify_read_watcher, UV__POLLIN);
   uv__close(loop->inotify_fd);
@@ -130,13 +179,233 @@ void uv__platform_invalidate_fd(uv_loop_t* loop, int fd) {
    *
    * We pass in a dummy epoll_event, to work around a bug in old kernels.
    */
-  if (loop->backend_fd >= 0) {
+  if (loop->backend_fd >= 0 && loop->iou == NULL) {
     /* Work around a bug in kernels 3.10 to 3.19 where passing a struct that
      * has the EPOLLWAKEUP flag set generates spurious audit syslog warnings.
      */
     memset(&dummy, 0, sizeof(dummy));
     uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, fd, &dummy);
+    loop->metrics.backend_ctl++;
+  }
+}
+
+
+/* Returns the events to hand to an edge-triggered watcher's callback. */
+static unsigned int uv__io_ready_events(const uv__io_t* w) {
+  unsigned int events;
+
+  if (w->pevents == 0)
+    return 0;
+
+  events = w->ready & (w->pevents | UV__POLLERR | UV__POLLHUP);
+
+  /* A partial read clears UV__POLLIN but a FIN that arrived together with
+   * the data still has to be picked up as EOF.
+   */
+  if (w->ready & UV__EPOLLRDHUP)
+    events |= w->pevents & UV__EPOLLIN;
+
+  /* Same quirk as in uv__io_poll() except that an error or hangup is now
+   * remembered until the watcher is closed.
+   */
+  if (events == UV__EPOLLERR || events == UV__EPOLLHUP)
+    events |= w->pevents & (UV__EPOLLIN | UV__EPOLLOUT);
+
+  return events;
+}
+
+
+/* The kernel only tells us about an edge once.  If the watcher still has
+ * readiness left that it's interested in (it stopped short of EAGAIN or it
+ * restarted a direction that became ready while stopped) then it goes on
+ * loop->ready_queue and is dispatched again on the next tick.
+ */
+void uv__io_check_ready(uv_loop_t* loop, uv__io_t* w) {
+  if (uv__io_ready_events(w) & (UV__EPOLLIN | UV__EPOLLOUT)) {
+    if (QUEUE_EMPTY(&w->ready_queue))
+      QUEUE_INSERT_TAIL(&loop->ready_queue, &w->ready_queue);
+  } else {
+    QUEUE_REMOVE(&w->ready_queue);
+    QUEUE_INIT(&w->ready_queue);
+  }
+}
+
+
+static int uv__io_run_ready(uv_loop_t* loop) {
+  unsigned int events;
+  QUEUE queue;
+  QUEUE* q;
+  uv__io_t* w;
+  int nevents;
+  int fd;
+
+  if (QUEUE_EMPTY(&loop->ready_queue))
+    return 0;
+
+  /* Watchers that are requeued by their callback run on the next tick. */
+  q = QUEUE_HEAD(&loop->ready_queue);
+  QUEUE_SPLIT(&loop->ready_queue, q, &queue);
+  nevents = 0;
+
+  while (!QUEUE_EMPTY(&queue)) {
+    q = QUEUE_HEAD(&queue);
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);
+
+    w = QUEUE_DATA(q, uv__io_t, ready_queue);
+    events = uv__io_ready_events(w);
+    if (events == 0)
+      continue;
+
+    fd = w->fd;
+    w->cb(loop, w, events);
+    nevents++;
+
+    if (fd >= 0 && w->fd == fd && loop->watchers[fd] == w)
+      uv__io_check_ready(loop, w);
+  }
+
+  uv__metrics_events(loop, nevents);
+  return nevents;
+}
+
+
+int uv__io_poll_batch(uv_loop_t* loop, int size, int budget) {
+  if (size < 0 || size > UV__POLL_BATCH_MAX || budget < 1)
+    return -EINVAL;
+
+  /* The buffer may be in use by the running uv__io_poll(), it's resized when
+   * the next one starts.
+   */
+  if (size == 0) {
+    /* Adapt, starting from the current size. */
+    loop->flags |= UV_LOOP_POLL_ADAPTIVE;
+  } else {
+    loop->flags &= ~UV_LOOP_POLL_ADAPTIVE;
+    loop->poll_batch = size;
+  }
+
+  loop->poll_budget = budget;
+  loop->poll_streak = 0;
+  return 0;
+}
+
+
+static void uv__io_poll_resize(uv_loop_t* loop) {
+  void* events;
+
+  events = uv__realloc(loop->poll_events,
+                       loop->poll_batch * sizeof(struct uv__epoll_event));
+
+  /* Not fatal, just carry on with the buffer that we have. */
+  if (events == NULL) {
+    loop->poll_batch = loop->poll_nevents;
+    return;
+  }
+
+  loop->poll_events = events;
+  loop->poll_nevents = loop->poll_batch;
+}
+
+
+/* Grow the buffer when a poll fills it, the kernel most likely had more
+ * events for us.  Shrink it again when it's mostly empty for a while.
+ */
+static void uv__io_poll_adapt(uv_loop_t* loop, int nfds) {
+  unsigned int size;
+
+  size = loop->poll_nevents;
+
+  if ((unsigned int) nfds == size) {
+    loop->poll_streak = 0;
+    if (size < UV__POLL_BATCH_MAX)
+      loop->poll_batch = size * 2;
+    return;
   }
+
+  if ((unsigned int) nfds > size / 4) {
+    loop->poll_streak = 0;
+    return;
+  }
+
+  if (++loop->poll_streak < UV__POLL_SHRINK_AFTER)
+    return;
+
+  loop->poll_streak = 0;
+  if (size / 2 >= UV__POLL_BATCH_MIN)
+    loop->poll_batch = size / 2;
+}
+
+
+static void uv__hrtimer_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
+  uint64_t expirations;
+
+  /* Drain the expiration count, there is no need to look at it. */
+  while (read(w->fd, &expirations, sizeof(expirations)) == -1 && errno == EINTR);
+
+  loop->hrtimer_armed = 0;
+  uv__run_hrtimers(loop);
+}
+
+
+/* Makes sure that the timerfd fires no later than `due`, which is in
+ * uv__hrtime(UV_CLOCK_PRECISE) units, i.e. CLOCK_MONOTONIC nanoseconds.
+ * Stopping the earliest timer doesn't push the deadline back, the spurious
+ * wakeup is cheaper than a timerfd_settime() on every restart.
+ */
+int uv__hrtimer_arm(uv_loop_t* loop, uint64_t due) {
+  struct itimerspec its;
+  int fd;
+
+  if (loop->hrtimer_watcher.fd == -1) {
+    fd = uv__timerfd_create(CLOCK_MONOTONIC,
+                            UV__TFD_CLOEXEC | UV__TFD_NONBLOCK);
+    if (fd == -1)
+      return -errno;
+
+    loop->hrtimer_watcher.fd = fd;
+    uv__io_start(loop, &loop->hrtimer_watcher, UV__POLLIN);
+  }
+
+  if (loop->hrtimer_armed != 0 && loop->hrtimer_armed <= due)
+    return 0;
+
+  /* A zero it_value disarms the timer, fire a nanosecond late instead. */
+  if (due == 0)
+    due = 1;
+
+  /* Keep tv_sec in range of a 32 bits time_t, that's still 68 years. */
+  if (due / 1000000000 > 0x7FFFFFFF)
+    due = (uint64_t) 0x7FFFFFFF * 1000000000;
+
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_sec = due / 1000000000;
+  its.it_value.tv_nsec = due % 1000000000;
+  if (uv__timerfd_settime(loop->hrtimer_watcher.fd,
+                          UV__TFD_TIMER_ABSTIME,
+                          &its,
+                          NULL))
+    return -errno;
+
+  loop->hrtimer_armed = due;
+  return 0;
+}
+
+
+/* With UV_LOOP_BUSY_POLL the loop polls without blocking for a while before
+ * it goes to sleep.  That trades CPU time for latency: a reply that arrives
+ * within the budget is picked up without the cost of a context switch.
+ * Returns the deadline in uv__hrtime(UV_CLOCK_PRECISE) units, never past the
+ * timeout that uv__io_poll() was called with.
+ */
+uint64_t uv__busy_poll_end(uv_loop_t* loop, int timeout) {
+  uint64_t budget;
+
+  budget = loop->busy_poll;
+  if (timeout != -1 && budget > (uint64_t) timeout * 1000000)
+    budget = (uint64_t) timeout * 1000000;
+
+  return uv__hrtime(UV_CLOCK_PRECISE) + budget;
 }
 
 
@@ -152,7 +421,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   static const int max_safe_timeout = 1789569;
   static int no_epoll_pwait;
   static int no_epoll_wait;
-  struct uv__epoll_event events[1024];
+  struct uv__epoll_event* events;
   struct uv__epoll_event* pe;
   struct uv__epoll_event e;
   int real_timeout;
@@ -161,18 +430,39 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   sigset_t sigset;
   uint64_t sigmask;
   uint64_t base;
+  uint64_t spin_end;
+  uint64_t idle_start;
+  int spin;
   int nevents;
+  int maxevents;
   int count;
   int nfds;
   int fd;
   int op;
   int i;
 
+  if (loop->iou != NULL) {
+    uv__iou_poll(loop, timeout);
+    return;
+  }
+
   if (loop->nfds == 0) {
     assert(QUEUE_EMPTY(&loop->watcher_queue));
     return;
   }
 
+  if (loop->poll_batch != loop->poll_nevents)
+    uv__io_poll_resize(loop);
+
+  events = loop->poll_events;
+  maxevents = loop->poll_nevents;
+
+  /* Edge-triggered watchers with leftover readiness won't be reported by
+   * epoll_wait() again; run them now and only peek at the backend.
+   */
+  if (uv__io_run_ready(loop) != 0)
+    timeout = 0;
+
   while (!QUEUE_EMPTY(&loop->watcher_queue)) {
     q = QUEUE_HEAD(&loop->watcher_queue);
     QUEUE_REMOVE(q);
@@ -186,14 +476,18 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     e.events = w->pevents;
     e.data = w->fd;
 
+    /* Register for both directions so that starting and stopping the
+     * watcher after this doesn't need epoll_ctl().
+     */
+    if ((loop->flags & UV_LOOP_EPOLLET) && w->edge)
+      e.events = UV__EPOLLIN | UV__EPOLLOUT | UV__EPOLLRDHUP | UV__EPOLLET;
+
     if (w->events == 0)
       op = UV__EPOLL_CTL_ADD;
     else
       op = UV__EPOLL_CTL_MOD;
 
-    /* XXX Future optimization: do EPOLL_CTL_MOD lazily if we stop watching
-     * events, skip the syscall and squelch the events after epoll_wait().
-     */
+    loop->metrics.backend_ctl++;
     if (uv__epoll_ctl(loop->backend_fd, op, w->fd, &e)) {
       if (errno != EEXIST)
         abort();
@@ -201,11 +495,13 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       assert(op == UV__EPOLL_CTL_ADD);
 
       /* We've reactivated a file descriptor that's been watched before. */
+      loop->metrics.backend_ctl++;
       if (uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_MOD, w->fd, &e))
         abort();
     }
 
-    w->events = w->pevents;
+    w->events = e.events;
+    w->unwanted = 0;
   }
 
   sigmask = 0;
@@ -217,9 +513,16 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
 
   assert(timeout >= -1);
   base = loop->time;
-  count = 48; /* Benchmarks suggest this gives the best throughput. */
+  count = loop->poll_budget;
   real_timeout = timeout;
 
+  spin = 0;
+  spin_end = 0;
+  if (timeout != 0 && loop->busy_poll != 0) {
+    spin = 1;
+    spin_end = uv__busy_poll_end(loop, timeout);
+  }
+
   for (;;) {
     /* See the comment for max_safe_timeout for an explanation of why
      * this is necessary.  Executive summary: kernel bug workaround.
@@ -227,6 +530,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (sizeof(int32_t) == sizeof(long) && timeout >= max_safe_timeout)
       timeout = max_safe_timeout;
 
+    idle_start = uv__metrics_poll_start(loop, timeout);
+
     if (sigmask != 0 && no_epoll_pwait != 0)
       if (pthread_sigmask(SIG_BLOCK, &sigset, NULL))
         abort();
@@ -234,16 +539,16 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (no_epoll_wait != 0 || (sigmask != 0 && no_epoll_pwait == 0)) {
       nfds = uv__epoll_pwait(loop->backend_fd,
                              events,
-                             ARRAY_SIZE(events),
-                             timeout,
+                             maxevents,
+                             spin ? 0 : timeout,
                              sigmask);
       if (nfds == -1 && errno == ENOSYS)
         no_epoll_pwait = 1;
     } else {
       nfds = uv__epoll_wait(loop->backend_fd,
                             events,
-                            ARRAY_SIZE(events),
-                            timeout);
+                            maxevents,
+                            spin ? 0 : timeout);
       if (nfds == -1 && errno == ENOSYS)
         no_epoll_wait = 1;
     }
@@ -252,12 +557,28 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
       if (pthread_sigmask(SIG_UNBLOCK, &sigset, NULL))
         abort();
 
+    SAVE_ERRNO(uv__metrics_poll_end(loop, idle_start));
+
     /* Update loop->time unconditionally. It's tempting to skip the update when
      * timeout == 0 (i.e. non-blocking poll) but there is no guarantee that the
      * operating system didn't reschedule our process while in the syscall.
      */
     SAVE_ERRNO(uv__update_time(loop));
 
+    if (nfds == 0 && spin) {
+      if (uv__hrtime(UV_CLOCK_PRECISE) < spin_end)
+        continue;
+
+      /* Out of budget, block for what's left of the timeout. */
+      spin = 0;
+      loop->metrics.busy_poll_misses++;
+
+      if (timeout == -1)
+        continue;
+
+      goto update_timeout;
+    }
+
     if (nfds == 0) {
       assert(timeout != -1);
 
@@ -313,9 +634,36 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
          * when the file descriptor is closed.
          */
         uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, fd, pe);
+        loop->metrics.backend_ctl++;
         continue;
       }
 
+      if (w->events & UV__EPOLLET) {
+        w->ready |= pe->events;
+        pe->events = uv__io_ready_events(w);
+
+        if (pe->events != 0) {
+          w->cb(loop, w, pe->events);
+          nevents++;
+
+          if (w->fd == fd && loop->watchers[fd] == w)
+            uv__io_check_ready(loop, w);
+        }
+        continue;
+      }
+
+      /* The kernel's event mask is a superset of w->pevents when
+       * uv__io_stop() skipped the EPOLL_CTL_MOD.  That's cheaper as long as
+       * the watcher is restarted soon.  If the fd keeps reporting events
+       * that nobody wants, fall back to updating the kernel's event mask.
+       */
+      if (pe->events & ~w->pevents & (UV__EPOLLIN | UV__EPOLLOUT)) {
+        if (++w->unwanted >= UV__EPOLL_UNWANTED_MAX &&
+            QUEUE_EMPTY(&w->watcher_queue)) {
+          QUEUE_INSERT_TAIL(&loop->watcher_queue, &w->watcher_queue);
+        }
+      }
+
       /* Give users only events they're interested in. Prevents spurious
        * callbacks when previous callback invocation in this loop has stopped
        * the current watcher. Also, filters out events that users has not
@@ -348,9 +696,18 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     }
     loop->watchers[loop->nwatchers] = NULL;
     loop->watchers[loop->nwatchers + 1] = NULL;
+    uv__metrics_events(loop, nevents);
+
+    if (loop->flags & UV_LOOP_POLL_ADAPTIVE)
+      uv__io_poll_adapt(loop, nfds);
 
     if (nevents != 0) {
-      if (nfds == ARRAY_SIZE(events) && --count != 0) {
+      if (spin) {
+        spin = 0;
+        loop->metrics.busy_poll_hits++;
+      }
+
+      if (nfds == maxevents && --count != 0) {
         /* Poll for more events but don't block this time. */
         timeout = 0;
         continue;
@@ -376,6 +733,123 @@ update_timeout:
 }
 
 
+/* Nanoseconds per TSC tick, or zero if the TSC can't be used as a clock. */
+static double uv__tsc_ns_per_tick;
+static uint64_t uv__tsc_rebase_ticks;
+static uv_once_t uv__tsc_once = UV_ONCE_INIT;
+
+
+#if defined(__x86_64__) && defined(__GNUC__)
+static uint64_t uv__rdtsc(void) {
+  uint32_t lo;
+  uint32_t hi;
+
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+
+static void uv__tsc_calibrate(void) {
+  uint32_t eax;
+  uint32_t ebx;
+  uint32_t ecx;
+  uint32_t edx;
+  struct timespec ts;
+  uint64_t tsc[2];
+  uint64_t ns[2];
+  char buf[32];
+  int fd;
+  int n;
+
+  /* The TSC must tick at a constant rate in all power states (invariant
+   * TSC) and the kernel must trust it enough to use it as its own clock
+   * source, i.e. it's synchronized across CPUs.
+   */
+  __asm__ __volatile__ ("cpuid"
+                        : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+                        : "a" (0x80000000));
+  if (eax < 0x80000007)
+    return;
+
+  __asm__ __volatile__ ("cpuid"
+                        : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+                        : "a" (0x80000007));
+  if ((edx & (1 << 8)) == 0)
+    return;
+
+  fd = uv__open_cloexec(
+      "/sys/devices/system/clocksource/clocksource0/current_clocksource",
+      O_RDONLY);
+  if (fd < 0)
+    return;
+
+  n = read(fd, buf, sizeof(buf) - 1);
+  uv__close(fd);
+  if (n < 3 || memcmp(buf, "tsc", 3) != 0)
+    return;
+
+  tsc[0] = uv__rdtsc();
+  ns[0] = uv__hrtime(UV_CLOCK_PRECISE);
+
+  ts.tv_sec = 0;
+  ts.tv_nsec = 5 * 1000 * 1000;
+  while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+
+  tsc[1] = uv__rdtsc();
+  ns[1] = uv__hrtime(UV_CLOCK_PRECISE);
+
+  if (tsc[1] <= tsc[0] || ns[1] <= ns[0])
+    return;
+
+  uv__tsc_ns_per_tick = (double) (ns[1] - ns[0]) / (tsc[1] - tsc[0]);
+  /* Rebase about once a second to keep the calibration error from adding
+   * up.
+   */
+  uv__tsc_rebase_ticks = (uint64_t) (1e9 / uv__tsc_ns_per_tick);
+}
+#else
+static uint64_t uv__rdtsc(void) {
+  return 0;
+}
+
+
+static void uv__tsc_calibrate(void) {
+}
+#endif
+
+
+int uv__tsc_init(uv_loop_t* loop) {
+  uv_once(&uv__tsc_once, uv__tsc_calibrate);
+
+  if (uv__tsc_ns_per_tick == 0)
+    return -ENOTSUP;
+
+  loop->tsc_base = uv__rdtsc();
+  loop->tsc_base_ns = uv__hrtime(UV_CLOCK_PRECISE);
+  return 0;
+}
+
+
+uint64_t uv__tsc_now(uv_loop_t* loop) {
+  uint64_t ticks;
+  uint64_t now;
+
+  ticks = uv__rdtsc() - loop->tsc_base;
+  now = loop->tsc_base_ns + (uint64_t) (ticks * uv__tsc_ns_per_tick);
+
+  if (ticks >= uv__tsc_rebase_ticks) {
+    loop->tsc_base = uv__rdtsc();
+    loop->tsc_base_ns = uv__hrtime(UV_CLOCK_PRECISE);
+    /* Never let the loop time go backwards. */
+    if (loop->tsc_base_ns < now)
+      loop->tsc_base_ns = now;
+    now = loop->tsc_base_ns;
+  }
+
+  return now;
+}
+
+
 uint64_t uv__hrtime(uv_clocktype_t type) {
   static clock_t fast_clock_id = -1;
   struct timespec t;
@@ -0,0 +1,970 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "internal.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+/* io_uring backend for uv__io_poll().
+ *
+ * Every watcher has at most one IORING_OP_POLL_ADD in flight.  Poll requests
+ * are one-shot: the watcher goes back on loop->watcher_queue when it fires
+ * and is re-armed with the next batch.  That keeps the level-triggered
+ * semantics that uv__read(), uv__write() and friends rely on.  Changes to
+ * the watcher queue are submitted together with the wait for completions,
+ * i.e. one io_uring_enter() system call per loop iteration.
+ *
+ * The user_data of a poll request holds the file descriptor in the upper
+ * 32 bits and the watcher's poll_id in the lower 32 bits.  Poll ids are
+ * odd, pointers (used by other requests) are not.  Completions of requests
+ * that the watcher has since replaced or cancelled don't match its poll_id
+ * anymore and are dropped.
+ *
+ * Asynchronous uv_fs_read(), uv_fs_write(), uv_fs_fsync(), uv_fs_fdatasync(),
+ * uv_fs_open(), uv_fs_close() and uv_fs_stat() and friends are submitted to
+ * the ring as well instead of going through the threadpool.  Their user_data
+ * is the uv_fs_t pointer.  uv_cancel() turns the SQE of a request that the
+ * kernel hasn't picked up yet into a no-op and sets bit 1 of the user_data.
+ *
+ * The completion queue is sized for the number of watchers, see
+ * uv__iou_grow().  Should it fill up anyway, the kernel holds on to the
+ * completions that didn't fit until io_uring_enter() is called with
+ * IORING_ENTER_GETEVENTS, and refuses new submissions meanwhile.
+ */
+
+#define UV__IOU_ENTRIES 256
+
+/* Bounds for the size of the completion queue.  The upper one is the
+ * kernel's limit.
+ */
+#define UV__IOU_MIN_CQ (2 * UV__IOU_ENTRIES)
+#define UV__IOU_MAX_CQ 65536
+
+#define uv__iou_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define uv__iou_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/* A completion that was taken out of the ring before it could be handled. */
+struct uv__iou_stashed {
+  uint64_t user_data;
+  int res;
+};
+
+struct uv__iou {
+  int ringfd;
+  uint32_t* sqhead;
+  uint32_t* sqtail;
+  uint32_t* sqflags;
+  uint32_t sqmask;
+  uint32_t sqentries;
+  uint32_t* cqhead;
+  uint32_t* cqtail;
+  uint32_t cqmask;
+  uint32_t cqentries;
+  struct uv__io_uring_cqe* cqes;
+  struct uv__io_uring_sqe* sqes;
+  void* ring;
+  size_t ringsize;
+  size_t sqesize;
+  unsigned int poll_seq;
+  unsigned int nreqs;  /* Filesystem requests in flight. */
+  /* Completions waiting for uv__iou_reap(), see uv__iou_get_sqe(). */
+  struct uv__iou_stashed* stash;
+  unsigned int nstash;
+  unsigned int stash_size;
+};
+
+
+static void uv__iou_unmap(struct uv__iou* iou) {
+  if (iou->sqes != NULL && iou->sqes != MAP_FAILED)
+    munmap(iou->sqes, iou->sqesize);
+
+  if (iou->ring != NULL && iou->ring != MAP_FAILED)
+    munmap(iou->ring, iou->ringsize);
+
+  if (iou->ringfd != -1)
+    uv__close(iou->ringfd);
+}
+
+
+/* Hands the queued submissions to the kernel without waiting for any
+ * completions.
+ */
+static void uv__iou_submit(struct uv__iou* iou) {
+  uint32_t pending;
+  int rc;
+
+  for (;;) {
+    pending = *iou->sqtail - uv__iou_load(iou->sqhead);
+    if (pending == 0)
+      return;
+
+    rc = uv__io_uring_enter(iou->ringfd, pending, 0, 0, NULL, 0);
+    if (rc >= 0)
+      continue;
+
+    if (errno == EINTR)
+      continue;
+
+    /* The completion queue is backed up.  uv__iou_poll() will drain it
+     * and try again.
+     */
+    if (errno == EAGAIN || errno == EBUSY)
+      return;
+
+    abort();
+  }
+}
+
+
+/* Has the kernel got completions that didn't fit into the ring?  Then
+ * flush as many of them into the ring as there is room for.  Returns
+ * non-zero if there were any.
+ */
+static int uv__iou_flush_overflow(struct uv__iou* iou) {
+  if (!(uv__iou_load(iou->sqflags) & UV__IORING_SQ_CQ_OVERFLOW))
+    return 0;
+
+  if (uv__io_uring_enter(iou->ringfd, 0, 0, UV__IORING_ENTER_GETEVENTS,
+                         NULL, 0)) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+      abort();
+  }
+
+  return 1;
+}
+
+
+/* Moves the completions out of the ring without handling them, that's up to
+ * uv__iou_reap().  Returns -1 if there's no memory to keep them in.
+ */
+static int uv__iou_stash(struct uv__iou* iou) {
+  struct uv__io_uring_cqe* cqe;
+  struct uv__iou_stashed* stash;
+  unsigned int size;
+  uint32_t head;
+  uint32_t tail;
+
+  head = *iou->cqhead;
+  tail = uv__iou_load(iou->cqtail);
+
+  if (tail - head > iou->stash_size - iou->nstash) {
+    size = 2 * iou->stash_size;
+    if (size < iou->nstash + (tail - head))
+      size = iou->nstash + (tail - head);
+    stash = uv__realloc(iou->stash, size * sizeof(*stash));
+    if (stash == NULL)
+      return -1;
+    iou->stash = stash;
+    iou->stash_size = size;
+  }
+
+  for (; head != tail; head++) {
+    cqe = iou->cqes + (head & iou->cqmask);
+    iou->stash[iou->nstash].user_data = cqe->user_data;
+    iou->stash[iou->nstash].res = cqe->res;
+    iou->nstash++;
+  }
+
+  uv__iou_store(iou->cqhead, head);
+  return 0;
+}
+
+
+static int uv__iou_sq_full(struct uv__iou* iou) {
+  return *iou->sqtail - uv__iou_load(iou->sqhead) >= iou->sqentries;
+}
+
+
+/* Returns NULL if the submission queue stays full.  That happens when the
+ * kernel refuses submissions because completions are backed up: they are
+ * moved aside to make room, unless we're out of memory.
+ */
+static struct uv__io_uring_sqe* uv__iou_get_sqe(struct uv__iou* iou) {
+  struct uv__io_uring_sqe* sqe;
+
+  while (uv__iou_sq_full(iou)) {
+    uv__iou_submit(iou);
+    if (!uv__iou_sq_full(iou))
+      break;
+
+    if (uv__iou_stash(iou))
+      return NULL;
+
+    if (!uv__iou_flush_overflow(iou)) {
+      uv__iou_submit(iou);
+      if (uv__iou_sq_full(iou))
+        return NULL;
+    }
+  }
+
+  sqe = iou->sqes + (*iou->sqtail & iou->sqmask);
+  memset(sqe, 0, sizeof(*sqe));
+
+  return sqe;
+}
+
+
+static void uv__iou_sqe_commit(struct uv__iou* iou) {
+  uv__iou_store(iou->sqtail, *iou->sqtail + 1);
+}
+
+
+/* Returns -1 if there's no room for the request, the watcher is unchanged
+ * then.
+ */
+static int uv__iou_poll_remove(struct uv__iou* iou, uv__io_t* w) {
+  struct uv__io_uring_sqe* sqe;
+
+  sqe = uv__iou_get_sqe(iou);
+  if (sqe == NULL)
+    return -1;
+
+  sqe->opcode = UV__IORING_OP_POLL_REMOVE;
+  sqe->addr = (uint64_t) (uint32_t) w->fd << 32 | w->poll_id;
+  sqe->user_data = 0;  /* Nothing to do when it completes. */
+  uv__iou_sqe_commit(iou);
+
+  w->poll_id = 0;
+  w->events = 0;
+
+  return 0;
+}
+
+
+/* Returns -1 if there's no room for the request.  The caller leaves the
+ * watcher on the watcher queue and tries again in the next iteration.
+ */
+static int uv__iou_poll_add(struct uv__iou* iou, uv__io_t* w) {
+  struct uv__io_uring_sqe* sqe;
+
+  if (w->poll_id != 0)
+    if (uv__iou_poll_remove(iou, w))
+      return -1;
+
+  sqe = uv__iou_get_sqe(iou);
+  if (sqe == NULL)
+    return -1;
+
+  iou->poll_seq++;
+  w->poll_id = iou->poll_seq << 1 | 1;
+
+  sqe->opcode = UV__IORING_OP_POLL_ADD;
+  sqe->fd = w->fd;
+  sqe->rw_flags = w->pevents;  /* poll32_events */
+  sqe->user_data = (uint64_t) (uint32_t) w->fd << 32 | w->poll_id;
+  uv__iou_sqe_commit(iou);
+
+  w->events = w->pevents;
+
+  return 0;
+}
+
+
+/* Room for the completion of a poll request and of its removal for every
+ * watcher.
+ */
+static uint32_t uv__iou_cq_size(unsigned int nfds) {
+  uint32_t size;
+
+  size = UV__IOU_MIN_CQ;
+  while (size < 2 * nfds && size < UV__IOU_MAX_CQ)
+    size *= 2;
+
+  return size;
+}
+
+
+/* Sets up the ring itself.  On error, `iou` has no ring. */
+static int uv__iou_setup(struct uv__iou* iou, uint32_t cq_entries) {
+  struct uv__io_uring_params params;
+  uint32_t* sqarray;
+  uint32_t need;
+  uint32_t i;
+  char* ring;
+  int err;
+
+  memset(&params, 0, sizeof(params));
+  params.flags = UV__IORING_SETUP_CQSIZE;
+  params.cq_entries = cq_entries;
+
+  iou->ring = NULL;
+  iou->sqes = NULL;
+  iou->ringfd = uv__io_uring_setup(UV__IOU_ENTRIES, &params);
+  if (iou->ringfd == -1)
+    return -errno;
+
+  /* Kernel 5.11 or newer. */
+  need = UV__IORING_FEAT_SINGLE_MMAP |
+         UV__IORING_FEAT_NODROP |
+         UV__IORING_FEAT_EXT_ARG;
+  if ((params.features & need) != need) {
+    err = -ENOSYS;
+    goto fail;
+  }
+
+  iou->ringsize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  i = params.cq_off.cqes +
+      params.cq_entries * sizeof(struct uv__io_uring_cqe);
+  if (iou->ringsize < i)
+    iou->ringsize = i;
+  iou->sqesize = params.sq_entries * sizeof(struct uv__io_uring_sqe);
+
+  iou->ring = mmap(NULL,
+                   iou->ringsize,
+                   PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE,
+                   iou->ringfd,
+                   UV__IORING_OFF_SQ_RING);
+  iou->sqes = mmap(NULL,
+                   iou->sqesize,
+                   PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE,
+                   iou->ringfd,
+                   UV__IORING_OFF_SQES);
+  if (iou->ring == MAP_FAILED || iou->sqes == MAP_FAILED) {
+    err = -errno;
+    goto fail;
+  }
+
+  ring = iou->ring;
+  iou->sqhead = (uint32_t*) (ring + params.sq_off.head);
+  iou->sqtail = (uint32_t*) (ring + params.sq_off.tail);
+  iou->sqflags = (uint32_t*) (ring + params.sq_off.flags);
+  iou->sqmask = *(uint32_t*) (ring + params.sq_off.ring_mask);
+  iou->sqentries = *(uint32_t*) (ring + params.sq_off.ring_entries);
+  iou->cqhead = (uint32_t*) (ring + params.cq_off.head);
+  iou->cqtail = (uint32_t*) (ring + params.cq_off.tail);
+  iou->cqmask = *(uint32_t*) (ring + params.cq_off.ring_mask);
+  iou->cqentries = *(uint32_t*) (ring + params.cq_off.ring_entries);
+  iou->cqes = (struct uv__io_uring_cqe*) (ring + params.cq_off.cqes);
+
+  /* Submission queue entries are used in ring order. */
+  sqarray = (uint32_t*) (ring + params.sq_off.array);
+  for (i = 0; i < iou->sqentries; i++)
+    sqarray[i] = i;
+
+  return 0;
+
+fail:
+  uv__iou_unmap(iou);
+  iou->ringfd = -1;
+  iou->ring = NULL;
+  iou->sqes = NULL;
+  return err;
+}
+
+
+/* The ring's file descriptor is readable when there are completions.
+ * Adding it to the epoll set keeps uv_backend_fd() useful for embedders.
+ */
+static void uv__iou_epoll_add(uv_loop_t* loop, struct uv__iou* iou) {
+  struct uv__epoll_event e;
+
+  memset(&e, 0, sizeof(e));
+  e.events = UV__EPOLLIN;
+  e.data = iou->ringfd;
+  uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_ADD, iou->ringfd, &e);
+}
+
+
+/* Replaces the ring with one whose completion queue fits the watchers the
+ * loop has now.  Filesystem requests in flight can't be moved over, it waits
+ * for them to finish.  Poll requests are simply made again.
+ */
+static void uv__iou_grow(uv_loop_t* loop, struct uv__iou* iou) {
+  struct uv__iou next;
+  unsigned int fd;
+  uv__io_t* w;
+
+  if (uv__iou_cq_size(loop->nfds) <= iou->cqentries)
+    return;
+
+  if (iou->nreqs != 0 || iou->nstash != 0)
+    return;
+
+  memset(&next, 0, sizeof(next));
+  if (uv__iou_setup(&next, uv__iou_cq_size(loop->nfds)))
+    return;  /* Carry on with the old one. */
+
+  next.poll_seq = iou->poll_seq;
+  next.stash = iou->stash;
+  next.stash_size = iou->stash_size;
+
+  /* Closing the old ring cancels its poll requests and takes it out of the
+   * epoll set.
+   */
+  uv__iou_unmap(iou);
+  *iou = next;
+  uv__iou_epoll_add(loop, iou);
+
+  for (fd = 0; fd < loop->nwatchers; fd++) {
+    w = loop->watchers[fd];
+    if (w == NULL)
+      continue;
+
+    w->poll_id = 0;
+    w->events = 0;
+
+    if (w->pevents != 0 && QUEUE_EMPTY(&w->watcher_queue))
+      QUEUE_INSERT_TAIL(&loop->watcher_queue, &w->watcher_queue);
+  }
+}
+
+
+int uv__iou_init(uv_loop_t* loop) {
+  struct uv__epoll_event e;
+  struct uv__iou* iou;
+  uv__io_t* w;
+  unsigned int fd;
+  int err;
+
+  if (loop->iou != NULL)
+    return 0;
+
+  iou = uv__malloc(sizeof(*iou));
+  if (iou == NULL)
+    return -ENOMEM;
+
+  memset(iou, 0, sizeof(*iou));
+
+  err = uv__iou_setup(iou, uv__iou_cq_size(loop->nfds));
+  if (err) {
+    uv__free(iou);
+    return err;
+  }
+
+  uv__iou_epoll_add(loop, iou);
+
+  /* Move the watchers that are already registered with epoll over. */
+  for (fd = 0; fd < loop->nwatchers; fd++) {
+    w = loop->watchers[fd];
+    if (w == NULL)
+      continue;
+
+    if (w->events != 0) {
+      memset(&e, 0, sizeof(e));
+      uv__epoll_ctl(loop->backend_fd, UV__EPOLL_CTL_DEL, fd, &e);
+      w->events = 0;
+    }
+
+    QUEUE_REMOVE(&w->ready_queue);
+    QUEUE_INIT(&w->ready_queue);
+    w->ready = 0;
+
+    if (w->pevents != 0 && QUEUE_EMPTY(&w->watcher_queue))
+      QUEUE_INSERT_TAIL(&loop->watcher_queue, &w->watcher_queue);
+  }
+
+  loop->iou = iou;
+  return 0;
+}
+
+
+void uv__iou_delete(uv_loop_t* loop) {
+  struct uv__iou* iou;
+
+  iou = loop->iou;
+  if (iou == NULL)
+    return;
+
+  uv__iou_unmap(iou);
+  uv__free(iou->stash);
+  uv__free(iou);
+  loop->iou = NULL;
+}
+
+
+/* Called from uv__io_close().  The in-flight poll request holds a reference
+ * to the file, cancel it now or close() won't really close the socket until
+ * the next loop iteration.
+ */
+void uv__iou_poll_cancel(uv_loop_t* loop, uv__io_t* w) {
+  struct uv__iou* iou;
+
+  iou = loop->iou;
+  if (iou == NULL || w->poll_id == 0)
+    return;
+
+  /* Out of memory and room.  The request lingers until it fires, its
+   * completion doesn't match any watcher then.
+   */
+  if (uv__iou_poll_remove(iou, w)) {
+    w->poll_id = 0;
+    w->events = 0;
+    return;
+  }
+
+  uv__iou_submit(iou);
+}
+
+
+static int uv__iou_poll_done(uv_loop_t* loop, uint64_t user_data, int res) {
+  unsigned int events;
+  unsigned int fd;
+  uv__io_t* w;
+
+  fd = user_data >> 32;
+  if (fd >= loop->nwatchers)
+    return 0;
+
+  w = loop->watchers[fd];
+  if (w == NULL || w->poll_id != (uint32_t) user_data)
+    return 0;  /* Stopped or re-armed since. */
+
+  w->poll_id = 0;
+  w->events = 0;
+
+  if (w->pevents != 0 && QUEUE_EMPTY(&w->watcher_queue))
+    QUEUE_INSERT_TAIL(&loop->watcher_queue, &w->watcher_queue);
+
+  if (res == -ECANCELED)
+    return 0;
+
+  /* The owner will run into the same error when it tries to do I/O. */
+  if (res < 0)
+    events = UV__POLLERR;
+  else
+    events = res;
+
+  /* See the comments in uv__io_poll() in linux-core.c. */
+  events &= w->pevents | UV__POLLERR | UV__POLLHUP;
+
+  if (events == UV__POLLERR || events == UV__POLLHUP)
+    events |= w->pevents & (UV__POLLIN | UV__POLLOUT);
+
+  if (events == 0)
+    return 0;
+
+  w->cb(loop, w, events);
+  return 1;
+}
+
+
+/* Returns 1 if the request was submitted to the ring, 0 if the caller should
+ * fall back to the threadpool.
+ */
+int uv__iou_fs_submit(uv_loop_t* loop, uv_fs_t* req) {
+  struct uv__io_uring_sqe* sqe;
+  struct uv__iou* iou;
+  struct uv__statx* statxbuf;
+
+  iou = loop->iou;
+  if (iou == NULL)
+    return 0;
+
+  statxbuf = NULL;
+  if (req->fs_type == UV_FS_STAT ||
+      req->fs_type == UV_FS_LSTAT ||
+      req->fs_type == UV_FS_FSTAT) {
+    statxbuf = uv__malloc(sizeof(*statxbuf));
+    if (statxbuf == NULL)
+      return 0;
+  }
+
+  sqe = uv__iou_get_sqe(iou);
+  if (sqe == NULL) {
+    uv__free(statxbuf);
+    return 0;
+  }
+
+  switch (req->fs_type) {
+  case UV_FS_READ:
+  case UV_FS_WRITE:
+    sqe->opcode = req->fs_type == UV_FS_READ ? UV__IORING_OP_READV
+                                             : UV__IORING_OP_WRITEV;
+    sqe->fd = req->file;
+    sqe->addr = (uint64_t) (uintptr_t) req->bufs;
+    sqe->len = req->nbufs;
+    sqe->off = req->off < 0 ? (uint64_t) -1 : (uint64_t) req->off;
+    break;
+  case UV_FS_FSYNC:
+  case UV_FS_FDATASYNC:
+    sqe->opcode = UV__IORING_OP_FSYNC;
+    sqe->fd = req->file;
+    if (req->fs_type == UV_FS_FDATASYNC)
+      sqe->rw_flags = UV__IORING_FSYNC_DATASYNC;
+    break;
+  case UV_FS_OPEN:
+    sqe->opcode = UV__IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uint64_t) (uintptr_t) req->path;
+    sqe->len = req->mode;
+    sqe->rw_flags = req->flags | O_CLOEXEC;
+    break;
+  case UV_FS_CLOSE:
+    sqe->opcode = UV__IORING_OP_CLOSE;
+    sqe->fd = req->file;
+    break;
+  case UV_FS_STAT:
+  case UV_FS_LSTAT:
+  case UV_FS_FSTAT:
+    sqe->opcode = UV__IORING_OP_STATX;
+    sqe->off = (uint64_t) (uintptr_t) statxbuf;
+    sqe->len = UV__STATX_BASIC_STATS | UV__STATX_BTIME;
+    if (req->fs_type == UV_FS_FSTAT) {
+      sqe->fd = req->file;
+      sqe->addr = (uint64_t) (uintptr_t) "";
+      sqe->rw_flags = AT_EMPTY_PATH;
+    } else {
+      sqe->fd = AT_FDCWD;
+      sqe->addr = (uint64_t) (uintptr_t) req->path;
+      if (req->fs_type == UV_FS_LSTAT)
+        sqe->rw_flags = AT_SYMLINK_NOFOLLOW;
+    }
+    req->ptr = statxbuf;
+    break;
+  default:
+    return 0;  /* The SQE is reused by the next caller. */
+  }
+
+  sqe->user_data = (uint64_t) (uintptr_t) req;
+  uv__iou_sqe_commit(iou);
+  iou->nreqs++;
+
+  /* Keep uv_cancel() away from the threadpool, see uv__iou_fs_cancel(). */
+  req->work_req.loop = loop;
+  req->work_req.work = NULL;
+  req->work_req.serial = NULL;
+  req->work_req.worker = 0;
+  QUEUE_INIT(&req->work_req.wq);
+
+  return 1;
+}
+
+
+/* Requests can be cancelled until io_uring_enter() hands them to the kernel.
+ * Returns UV_EBUSY when that has happened already, or when the request
+ * isn't on the ring at all.
+ */
+int uv__iou_fs_cancel(uv_loop_t* loop, uv_fs_t* req) {
+  struct uv__io_uring_sqe* sqe;
+  struct uv__iou* iou;
+  uint32_t pos;
+
+  iou = loop->iou;
+  if (iou == NULL)
+    return -EBUSY;
+
+  for (pos = uv__iou_load(iou->sqhead); pos != *iou->sqtail; pos++) {
+    sqe = iou->sqes + (pos & iou->sqmask);
+    if (sqe->user_data != (uint64_t) (uintptr_t) req)
+      continue;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = UV__IORING_OP_NOP;
+    sqe->user_data = (uint64_t) (uintptr_t) req | 2;
+    return 0;
+  }
+
+  return -EBUSY;
+}
+
+
+static void uv__iou_statx_to_stat(const struct uv__statx* src,
+                                  uv_stat_t* dst) {
+  dst->st_dev = makedev(src->stx_dev_major, src->stx_dev_minor);
+  dst->st_mode = src->stx_mode;
+  dst->st_nlink = src->stx_nlink;
+  dst->st_uid = src->stx_uid;
+  dst->st_gid = src->stx_gid;
+  dst->st_rdev = makedev(src->stx_rdev_major, src->stx_rdev_minor);
+  dst->st_ino = src->stx_ino;
+  dst->st_size = src->stx_size;
+  dst->st_blksize = src->stx_blksize;
+  dst->st_blocks = src->stx_blocks;
+  dst->st_atim.tv_sec = src->stx_atime.tv_sec;
+  dst->st_atim.tv_nsec = src->stx_atime.tv_nsec;
+  dst->st_mtim.tv_sec = src->stx_mtime.tv_sec;
+  dst->st_mtim.tv_nsec = src->stx_mtime.tv_nsec;
+  dst->st_ctim.tv_sec = src->stx_ctime.tv_sec;
+  dst->st_ctim.tv_nsec = src->stx_ctime.tv_nsec;
+  /* Not every file system knows the birth time.  Use the ctime then, like
+   * uv__to_stat() in fs.c does.
+   */
+  if (src->stx_mask & UV__STATX_BTIME) {
+    dst->st_birthtim.tv_sec = src->stx_btime.tv_sec;
+    dst->st_birthtim.tv_nsec = src->stx_btime.tv_nsec;
+  } else {
+    dst->st_birthtim = dst->st_ctim;
+  }
+  dst->st_flags = 0;
+  dst->st_gen = 0;
+}
+
+
+static void uv__iou_fs_done(uv_loop_t* loop, uv_fs_t* req, int res) {
+  struct uv__iou* iou;
+
+  iou = loop->iou;
+  assert(iou->nreqs > 0);
+  iou->nreqs--;
+
+  req->result = res;
+
+  switch (req->fs_type) {
+  case UV_FS_READ:
+  case UV_FS_WRITE:
+    if (req->bufs != req->bufsml)
+      uv__free(req->bufs);
+    req->bufs = NULL;
+    break;
+  case UV_FS_STAT:
+  case UV_FS_LSTAT:
+  case UV_FS_FSTAT:
+    if (res == 0)
+      uv__iou_statx_to_stat(req->ptr, &req->statbuf);
+    uv__free(req->ptr);
+    req->ptr = NULL;
+    if (res == 0)
+      req->ptr = &req->statbuf;
+    break;
+  default:
+    break;
+  }
+
+  uv__req_unregister(loop, req);
+  req->cb(req);
+}
+
+
+static int uv__iou_complete(uv_loop_t* loop, uint64_t user_data, int res) {
+  if (user_data & 1)
+    return uv__iou_poll_done(loop, user_data, res);
+
+  if (user_data == 0)
+    return 0;
+
+  if (user_data & 2) {
+    user_data &= ~(uint64_t) 2;
+    res = -ECANCELED;
+  }
+
+  uv__iou_fs_done(loop, (uv_fs_t*) (uintptr_t) user_data, res);
+  return 1;
+}
+
+
+static int uv__iou_reap(uv_loop_t* loop, struct uv__iou* iou) {
+  struct uv__io_uring_cqe* cqe;
+  uint64_t user_data;
+  unsigned int i;
+  uint32_t head;
+  int nevents;
+  int res;
+
+  nevents = 0;
+
+  for (;;) {
+    /* Stashed completions are older than the ones in the ring.  Callbacks
+     * may stash more, they're handled in the same pass.
+     */
+    for (i = 0; i < iou->nstash; i++)
+      nevents += uv__iou_complete(loop,
+                                  iou->stash[i].user_data,
+                                  iou->stash[i].res);
+    iou->nstash = 0;
+
+    for (;;) {
+      head = *iou->cqhead;
+      if (head == uv__iou_load(iou->cqtail))
+        break;
+
+      /* Release the slot before running the callback, it may submit. */
+      cqe = iou->cqes + (head & iou->cqmask);
+      user_data = cqe->user_data;
+      res = cqe->res;
+      uv__iou_store(iou->cqhead, head + 1);
+
+      nevents += uv__iou_complete(loop, user_data, res);
+    }
+
+    /* Completions that didn't fit are only posted once there's room. */
+    if (iou->nstash == 0 && !uv__iou_flush_overflow(iou))
+      break;
+  }
+
+  uv__metrics_events(loop, nevents);
+  return nevents;
+}
+
+
+void uv__iou_poll(uv_loop_t* loop, int timeout) {
+  struct uv__io_uring_getevents_arg arg;
+  struct uv__io_uring_timespec ts;
+  struct uv__iou* iou;
+  uint64_t sigmask;
+  uint64_t base;
+  uint64_t spin_end;
+  uint64_t idle_start;
+  uint32_t pending;
+  unsigned int flags;
+  QUEUE* q;
+  uv__io_t* w;
+  int real_timeout;
+  int nevents;
+  int spin;
+  int rc;
+
+  iou = loop->iou;
+
+  if (loop->nfds == 0 && iou->nreqs == 0) {
+    assert(QUEUE_EMPTY(&loop->watcher_queue));
+    return;
+  }
+
+  uv__iou_grow(loop, iou);
+
+  while (!QUEUE_EMPTY(&loop->watcher_queue)) {
+    q = QUEUE_HEAD(&loop->watcher_queue);
+    w = QUEUE_DATA(q, uv__io_t, watcher_queue);
+    assert(w->pevents != 0);
+    assert(w->fd >= 0);
+    assert(w->fd < (int) loop->nwatchers);
+
+    /* No room, the rest waits for the next iteration.  Don't block until
+     * then.
+     */
+    if (uv__iou_poll_add(iou, w)) {
+      timeout = 0;
+      break;
+    }
+
+    QUEUE_REMOVE(q);
+    QUEUE_INIT(q);
+  }
+
+  sigmask = 0;
+  if (loop->flags & UV_LOOP_BLOCK_SIGPROF)
+    sigmask |= 1 << (SIGPROF - 1);
+
+  assert(timeout >= -1);
+  base = loop->time;
+  real_timeout = timeout;
+
+  spin = 0;
+  spin_end = 0;
+  if (timeout != 0 && loop->busy_poll != 0) {
+    spin = 1;
+    spin_end = uv__busy_poll_end(loop, timeout);
+  }
+
+  for (;;) {
+    pending = *iou->sqtail - uv__iou_load(iou->sqhead);
+    idle_start = uv__metrics_poll_start(loop, timeout);
+
+    if (spin) {
+      /* Let the kernel run deferred completion work without waiting. */
+      rc = 0;
+      if (pending != 0 ||
+          *iou->cqhead == uv__iou_load(iou->cqtail) ||
+          (uv__iou_load(iou->sqflags) & UV__IORING_SQ_CQ_OVERFLOW))
+        rc = uv__io_uring_enter(iou->ringfd,
+                                pending,
+                                0,
+                                UV__IORING_ENTER_GETEVENTS,
+                                NULL,
+                                0);
+    } else if (timeout == 0) {
+      /* Nothing to wait for, don't enter the kernel unless we have to.
+       * Completions that overflowed are only flushed with GETEVENTS.
+       */
+      flags = 0;
+      if (uv__iou_load(iou->sqflags) & UV__IORING_SQ_CQ_OVERFLOW)
+        flags = UV__IORING_ENTER_GETEVENTS;
+      rc = 0;
+      if (pending != 0 || flags != 0)
+        rc = uv__io_uring_enter(iou->ringfd, pending, 0, flags, NULL, 0);
+    } else {
+      memset(&arg, 0, sizeof(arg));
+      if (sigmask != 0) {
+        arg.sigmask = (uint64_t) (uintptr_t) &sigmask;
+        arg.sigmask_sz = sizeof(sigmask);
+      }
+      if (timeout != -1) {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000;
+        arg.ts = (uint64_t) (uintptr_t) &ts;
+      }
+      rc = uv__io_uring_enter(iou->ringfd,
+                              pending,
+                              1,
+                              UV__IORING_ENTER_GETEVENTS |
+                                  UV__IORING_ENTER_EXT_ARG,
+                              &arg,
+                              sizeof(arg));
+    }
+
+    SAVE_ERRNO(uv__metrics_poll_end(loop, idle_start));
+
+    /* Update loop->time unconditionally, see uv__io_poll(). */
+    SAVE_ERRNO(uv__update_time(loop));
+
+    if (rc == -1) {
+      if (errno != ETIME &&
+          errno != EINTR &&
+          errno != EAGAIN &&
+          errno != EBUSY) {
+        abort();
+      }
+    }
+
+    nevents = uv__iou_reap(loop, iou);
+    if (nevents != 0) {
+      if (spin)
+        loop->metrics.busy_poll_hits++;
+      return;
+    }
+
+    if (timeout == 0)
+      return;
+
+    if (spin) {
+      if (uv__hrtime(UV_CLOCK_PRECISE) < spin_end)
+        continue;
+
+      /* Out of budget, block for what's left of the timeout. */
+      spin = 0;
+      loop->metrics.busy_poll_misses++;
+    }
+
+    if (timeout == -1)
+      continue;
+
+    assert(timeout > 0);
+
+    real_timeout -= (loop->time - base);
+    if (real_timeout <= 0)
+      return;
+
+    timeout = real_timeout;
+  }
+}
@@ -237,6 +237,46 @@
 # endif
 #endif /* __NR_pwritev */
 
+#ifndef __NR_timerfd_create
+# if defined(__x86_64__)
+#  define __NR_timerfd_create 283
+# elif defined(__i386__)
+#  define __NR_timerfd_create 322
+# elif defined(__aarch64__)
+#  define __NR_timerfd_create 85
+# elif defined(__arm__)
+#  define __NR_timerfd_create (UV_SYSCALL_BASE + 350)
+# endif
+#endif /* __NR_timerfd_create */
+
+#ifndef __NR_timerfd_settime
+# if defined(__x86_64__)
+#  define __NR_timerfd_settime 286
+# elif defined(__i386__)
+#  define __NR_timerfd_settime 325
+# elif defined(__aarch64__)
+#  define __NR_timerfd_settime 86
+# elif defined(__arm__)
+#  define __NR_timerfd_settime (UV_SYSCALL_BASE + 353)
+# endif
+#endif /* __NR_timerfd_settime */
+
+#ifndef __NR_io_uring_setup
+# if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+#  define __NR_io_uring_setup 425
+# elif defined(__arm__)
+#  define __NR_io_uring_setup (UV_SYSCALL_BASE + 425)
+# endif
+#endif /* __NR_io_uring_setup */
+
+#ifndef __NR_io_uring_enter
+# if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+#  define __NR_io_uring_enter 426
+# elif defined(__arm__)
+#  define __NR_io_uring_enter (UV_SYSCALL_BASE + 426)
+# endif
+#endif /* __NR_io_uring_enter */
+
 
 int uv__accept4(int fd, struct sockaddr* addr, socklen_t* addrlen, int flags) {
 #if defined(__i386__)
@@ -469,3 +509,53 @@ int uv__dup3(int oldfd, int newfd, int flags) {
   return errno = ENOSYS, -1;
 #endif
 }
+
+
+int uv__timerfd_create(int clockid, int flags) {
+#if defined(__NR_timerfd_create)
+  return syscall(__NR_timerfd_create, clockid, flags);
+#else
+  return errno = ENOSYS, -1;
+#endif
+}
+
+
+int uv__timerfd_settime(int fd,
+                        int flags,
+                        const struct itimerspec* new_value,
+                        struct itimerspec* old_value) {
+#if defined(__NR_timerfd_settime)
+  return syscall(__NR_timerfd_settime, fd, flags, new_value, old_value);
+#else
+  return errno = ENOSYS, -1;
+#endif
+}
+
+
+int uv__io_uring_setup(unsigned int entries, struct uv__io_uring_params* params) {
+#if defined(__NR_io_uring_setup)
+  return syscall(__NR_io_uring_setup, entries, params);
+#else
+  return errno = ENOSYS, -1;
+#endif
+}
+
+
+int uv__io_uring_enter(int fd,
+                       unsigned int to_submit,
+                       unsigned int min_complete,
+                       unsigned int flags,
+                       const void* arg,
+                       size_t argsz) {
+#if defined(__NR_io_uring_enter)
+  return syscall(__NR_io_uring_enter,
+                 fd,
+                 to_submit,
+                 min_complete,
+                 flags,
+                 arg,
+                 argsz);
+#else
+  return errno = ENOSYS, -1;
+#endif
+}
@@ -29,6 +29,7 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/socket.h>
 
 #if defined(__alpha__)
@@ -59,6 +60,10 @@
 #define UV__IN_CLOEXEC        UV__O_CLOEXEC
 #define UV__IN_NONBLOCK       UV__O_NONBLOCK
 
+#define UV__TFD_CLOEXEC       UV__O_CLOEXEC
+#define UV__TFD_NONBLOCK      UV__O_NONBLOCK
+#define UV__TFD_TIMER_ABSTIME 1
+
 #define UV__SOCK_CLOEXEC      UV__O_CLOEXEC
 #if defined(SOCK_NONBLOCK)
 # define UV__SOCK_NONBLOCK    SOCK_NONBLOCK
@@ -76,6 +81,7 @@
 #define UV__EPOLLOUT          4
 #define UV__EPOLLERR          8
 #define UV__EPOLLHUP          16
+#define UV__EPOLLRDHUP        0x2000
 #define UV__EPOLLONESHOT      0x40000000
 #define UV__EPOLLET           0x80000000
 
@@ -118,6 +124,142 @@ struct uv__mmsghdr {
   unsigned int msg_len;
 };
 
+/* io_uring */
+#define UV__IORING_OFF_SQ_RING      0
+#define UV__IORING_OFF_SQES         0x10000000
+
+#define UV__IORING_ENTER_GETEVENTS  1u
+#define UV__IORING_ENTER_EXT_ARG    8u
+
+#define UV__IORING_SETUP_CQSIZE     8u
+
+#define UV__IORING_SQ_CQ_OVERFLOW   2u
+
+#define UV__IORING_FEAT_SINGLE_MMAP 1u
+#define UV__IORING_FEAT_NODROP      2u
+#define UV__IORING_FEAT_EXT_ARG     256u
+
+#define UV__IORING_OP_NOP           0
+#define UV__IORING_OP_READV         1
+#define UV__IORING_OP_WRITEV        2
+#define UV__IORING_OP_FSYNC         3
+#define UV__IORING_OP_POLL_ADD      6
+#define UV__IORING_OP_POLL_REMOVE   7
+#define UV__IORING_OP_OPENAT        18
+#define UV__IORING_OP_CLOSE         19
+#define UV__IORING_OP_STATX         21
+
+#define UV__IORING_FSYNC_DATASYNC   1u
+
+/* statx */
+#define UV__STATX_BASIC_STATS       0x7ff
+#define UV__STATX_BTIME             0x800
+
+struct uv__io_sqring_offsets {
+  uint32_t head;
+  uint32_t tail;
+  uint32_t ring_mask;
+  uint32_t ring_entries;
+  uint32_t flags;
+  uint32_t dropped;
+  uint32_t array;
+  uint32_t reserved0;
+  uint64_t reserved1;
+};
+
+struct uv__io_cqring_offsets {
+  uint32_t head;
+  uint32_t tail;
+  uint32_t ring_mask;
+  uint32_t ring_entries;
+  uint32_t overflow;
+  uint32_t cqes;
+  uint32_t flags;
+  uint32_t reserved0;
+  uint64_t reserved1;
+};
+
+struct uv__io_uring_params {
+  uint32_t sq_entries;
+  uint32_t cq_entries;
+  uint32_t flags;
+  uint32_t sq_thread_cpu;
+  uint32_t sq_thread_idle;
+  uint32_t features;
+  uint32_t wq_fd;
+  uint32_t reserved[3];
+  struct uv__io_sqring_offsets sq_off;
+  struct uv__io_cqring_offsets cq_off;
+};
+
+/* The anonymous unions of the kernel's struct io_uring_sqe are flattened
+ * into their first member; rw_flags doubles as poll32_events, fsync_flags,
+ * open_flags, etc.
+ */
+struct uv__io_uring_sqe {
+  uint8_t opcode;
+  uint8_t flags;
+  uint16_t ioprio;
+  int32_t fd;
+  uint64_t off;
+  uint64_t addr;
+  uint32_t len;
+  uint32_t rw_flags;
+  uint64_t user_data;
+  uint16_t buf_index;
+  uint16_t personality;
+  int32_t splice_fd_in;
+  uint64_t pad[2];
+};
+
+struct uv__io_uring_cqe {
+  uint64_t user_data;
+  int32_t res;
+  uint32_t flags;
+};
+
+struct uv__statx_timestamp {
+  int64_t tv_sec;
+  uint32_t tv_nsec;
+  int32_t reserved;
+};
+
+struct uv__statx {
+  uint32_t stx_mask;
+  uint32_t stx_blksize;
+  uint64_t stx_attributes;
+  uint32_t stx_nlink;
+  uint32_t stx_uid;
+  uint32_t stx_gid;
+  uint16_t stx_mode;
+  uint16_t unused0;
+  uint64_t stx_ino;
+  uint64_t stx_size;
+  uint64_t stx_blocks;
+  uint64_t stx_attributes_mask;
+  struct uv__statx_timestamp stx_atime;
+  struct uv__statx_timestamp stx_btime;
+  struct uv__statx_timestamp stx_ctime;
+  struct uv__statx_timestamp stx_mtime;
+  uint32_t stx_rdev_major;
+  uint32_t stx_rdev_minor;
+  uint32_t stx_dev_major;
+  uint32_t stx_dev_minor;
+  uint64_t unused1[14];
+};
+
+struct uv__io_uring_timespec {
+  int64_t tv_sec;
+  int64_t tv_nsec;
+};
+
+struct uv__io_uring_getevents_arg {
+  uint64_t sigmask;
+  uint32_t sigmask_sz;
+  uint32_t pad;
+  uint64_t ts;
+};
+
 int uv__accept4(int fd, struct sockaddr* addr, socklen_t* addrlen, int flags);
 int uv__eventfd(unsigned int count);
 int uv__epoll_create(int size);
@@ -154,5 +296,17 @@ int uv__utimesat(int dirfd,
 ssize_t uv__preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset);
 ssize_t uv__pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset);
 int uv__dup3(int oldfd, int newfd, int flags);
+int uv__timerfd_create(int clockid, int flags);
+int uv__timerfd_settime(int fd,
+                        int flags,
+                        const struct itimerspec* new_value,
+                        struct itimerspec* old_value);
+int uv__io_uring_setup(unsigned int entries, struct uv__io_uring_params* params);
+int uv__io_uring_enter(int fd,
+                       unsigned int to_submit,
+                       unsigned int min_complete,
+                       unsigned int flags,
+                       const void* arg,
+                       size_t argsz);
 
 #endif /* UV_LINUX_SYSCALL_H_ */
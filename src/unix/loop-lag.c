@@ -0,0 +1,167 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "internal.h"
+
+#include <string.h>
+
+/* Log-linear histogram in the style of HdrHistogram.  Values below 2^BITS
+ * nanoseconds get a bucket each, above that every power of two is split into
+ * 2^(BITS - 1) buckets.  With BITS = 5 a bucket is never wider than 1/16th
+ * of its lower bound, i.e. a reported percentile is off by less than 6.25%.
+ */
+#define UV__LAG_BITS 5
+#define UV__LAG_HALF (1 << (UV__LAG_BITS - 1))
+#define UV__LAG_BUCKETS ((64 - UV__LAG_BITS + 2) * UV__LAG_HALF)
+
+struct uv__lag_histogram {
+  uint64_t count;
+  uint64_t max;
+  uint64_t buckets[UV__LAG_BUCKETS];
+};
+
+struct uv__lag {
+  struct uv__lag_histogram h[2];  /* Indexed by uv_lag_type. */
+};
+
+
+static unsigned int uv__lag_msb(uint64_t value) {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(value);
+#else
+  unsigned int n;
+
+  for (n = 0; value >>= 1; n++);
+  return n;
+#endif
+}
+
+
+static unsigned int uv__lag_index(uint64_t value) {
+  unsigned int shift;
+
+  if (value < 2 * UV__LAG_HALF)
+    return (unsigned int) value;
+
+  shift = uv__lag_msb(value) - (UV__LAG_BITS - 1);
+  return (shift * UV__LAG_HALF) + (unsigned int) (value >> shift);
+}
+
+
+/* Returns the largest value that maps to bucket `index`. */
+static uint64_t uv__lag_value(unsigned int index) {
+  unsigned int shift;
+  uint64_t mantissa;
+
+  if (index < 2 * UV__LAG_HALF)
+    return index;
+
+  shift = index / UV__LAG_HALF - 1;
+  mantissa = index - shift * UV__LAG_HALF;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+
+int uv__lag_init(uv_loop_t* loop) {
+  if (loop->lag != NULL)
+    return 0;
+
+  loop->lag = uv__calloc(1, sizeof(struct uv__lag));
+  if (loop->lag == NULL)
+    return -ENOMEM;
+
+  return 0;
+}
+
+
+void uv__lag_delete(uv_loop_t* loop) {
+  uv__free(loop->lag);
+  loop->lag = NULL;
+}
+
+
+void uv__lag_record(uv_loop_t* loop, uv_lag_type type, uint64_t value) {
+  struct uv__lag_histogram* h;
+
+  h = ((struct uv__lag*) loop->lag)->h + type;
+  h->buckets[uv__lag_index(value)]++;
+  h->count++;
+  if (value > h->max)
+    h->max = value;
+}
+
+
+int uv_loop_lag(const uv_loop_t* loop,
+                uv_lag_type type,
+                double percentile,
+                uint64_t* value) {
+  const struct uv__lag_histogram* h;
+  double target;
+  uint64_t rank;
+  uint64_t seen;
+  unsigned int i;
+
+  if (loop->lag == NULL)
+    return -EINVAL;
+
+  if (type != UV_LAG_TIMER && type != UV_LAG_ITERATION)
+    return -EINVAL;
+
+  if (!(percentile >= 0 && percentile <= 100))
+    return -EINVAL;
+
+  h = ((const struct uv__lag*) loop->lag)->h + type;
+  *value = 0;
+
+  if (h->count == 0)
+    return 0;
+
+  /* The smallest value that's at least as large as `percentile` percent of
+   * the samples.
+   */
+  target = percentile / 100 * h->count;
+  rank = (uint64_t) target;
+  if (rank < target || rank == 0)
+    rank++;
+
+  seen = 0;
+  for (i = 0; i < UV__LAG_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= rank)
+      break;
+  }
+
+  *value = uv__lag_value(i);
+  if (*value > h->max)
+    *value = h->max;
+
+  return 0;
+}
+
+
+int uv_loop_lag_reset(uv_loop_t* loop) {
+  if (loop->lag == NULL)
+    return -EINVAL;
+
+  memset(loop->lag, 0, sizeof(struct uv__lag));
+  return 0;
+}
@@ -50,6 +50,7 @@
     QUEUE* q;                                                                 \
     QUEUE_FOREACH(q, &loop->name##_handles) {                                 \
       h = QUEUE_DATA(q, uv_##name##_t, queue);                                \
+      loop->metrics.callbacks++;                                              \
       h->name##_cb(h);                                                        \
     }                                                                         \
   }                                                                           \
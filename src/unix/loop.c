@@ -22,7 +22,7 @@
 #include "uv.h"
 #include "tree.h"
 #include "internal.h"
-#include "heap-inl.h"
+#include "dheap-inl.h"
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -33,11 +33,13 @@ int uv_loop_init(uv_loop_t* loop) {
   uv__signal_global_once_init();
 
   memset(loop, 0, sizeof(*loop));
-  heap_init((struct heap*) &loop->timer_heap);
+  dheap_init((struct dheap*) &loop->timer_heap);
   QUEUE_INIT(&loop->wq);
+  loop->wq_completed = NULL;
   QUEUE_INIT(&loop->active_reqs);
   QUEUE_INIT(&loop->idle_handles);
   QUEUE_INIT(&loop->async_handles);
+  loop->async_pending = NULL;
   QUEUE_INIT(&loop->check_handles);
   QUEUE_INIT(&loop->prepare_handles);
   QUEUE_INIT(&loop->handle_queue);
@@ -88,6 +90,9 @@ void uv__loop_close(uv_loop_t* loop) {
   uv__signal_loop_cleanup(loop);
   uv__platform_loop_delete(loop);
   uv__async_stop(loop, &loop->async_watcher);
+  uv__lag_delete(loop);
+  uv__timer_wheel_delete(loop);
+  dheap_free((struct dheap*) &loop->timer_heap);
 
   if (loop->emfile_fd != -1) {
     uv__close(loop->emfile_fd);
@@ -101,6 +106,7 @@ void uv__loop_close(uv_loop_t* loop) {
 
   uv_mutex_lock(&loop->wq_mutex);
   assert(QUEUE_EMPTY(&loop->wq) && "thread pool work queue not empty!");
+  assert(loop->wq_completed == NULL);
   assert(!uv__has_active_reqs(loop));
   uv_mutex_unlock(&loop->wq_mutex);
   uv_mutex_destroy(&loop->wq_mutex);
@@ -124,6 +130,87 @@ void uv__loop_close(uv_loop_t* loop) {
 
 
 int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap) {
+  if (option == UV_LOOP_EDGE_TRIGGERED) {
+#if defined(__linux__)
+    loop->flags |= UV_LOOP_EPOLLET;
+    return 0;
+#else
+    return UV_ENOSYS;
+#endif
+  }
+
+  if (option == UV_LOOP_USE_IO_URING) {
+#if defined(__linux__)
+    /* Stay with epoll if the kernel doesn't support io_uring. */
+    uv__iou_init(loop);
+    return 0;
+#else
+    return UV_ENOSYS;
+#endif
+  }
+
+  if (option == UV_LOOP_BUSY_POLL) {
+#if defined(__linux__)
+    int usec;
+
+    usec = va_arg(ap, int);
+    if (usec < 0)
+      return UV_EINVAL;
+
+    loop->busy_poll = (uint64_t) usec * 1000;
+    return 0;
+#else
+    return UV_ENOSYS;
+#endif
+  }
+
+  if (option == UV_LOOP_POLL_BATCH) {
+#if defined(__linux__)
+    int size;
+    int budget;
+
+    size = va_arg(ap, int);
+    budget = va_arg(ap, int);
+    return uv__io_poll_batch(loop, size, budget);
+#else
+    return UV_ENOSYS;
+#endif
+  }
+
+  if (option == UV_LOOP_METRICS_TIME) {
+    loop->flags |= UV_LOOP_PHASE_TIMES;
+    return 0;
+  }
+
+  if (option == UV_LOOP_LAG_HISTOGRAM)
+    return uv__lag_init(loop);
+
+  if (option == UV_LOOP_TIMER_WHEEL)
+    return uv__timer_wheel_init(loop);
+
+  if (option == UV_LOOP_CLOCK_MODE) {
+    int mode;
+
+    mode = va_arg(ap, int);
+    if (mode != UV_CLOCK_MODE_DEFAULT &&
+        mode != UV_CLOCK_MODE_PRECISE &&
+        mode != UV_CLOCK_MODE_FAST) {
+      return UV_EINVAL;
+    }
+
+    loop->flags &= ~(UV_LOOP_CLOCK_PRECISE | UV_LOOP_CLOCK_TSC);
+    if (mode == UV_CLOCK_MODE_PRECISE)
+      loop->flags |= UV_LOOP_CLOCK_PRECISE;
+#if defined(__linux__)
+    /* Without a usable TSC this is the same as UV_CLOCK_MODE_DEFAULT. */
+    if (mode == UV_CLOCK_MODE_FAST && uv__tsc_init(loop) == 0)
+      loop->flags |= UV_LOOP_CLOCK_TSC;
+#endif
+
+    uv__update_time(loop);
+    return 0;
+  }
+
   if (option != UV_LOOP_BLOCK_SIGNAL)
     return UV_ENOSYS;
 
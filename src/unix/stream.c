@@ -103,6 +103,7 @@ void uv__stream_init(uv_loop_t* loop,
 #endif /* defined(__APPLE_) */
 
   uv__io_init(&stream->io_watcher, uv__stream_io, -1);
+  uv__io_allow_edge(&stream->io_watcher);
 }
 
 
@@ -527,16 +528,20 @@ void uv__server_io(uv_loop_t* loop, uv__io_t* w, unsigned int events) {
 
     err = uv__accept(uv__stream_fd(stream));
     if (err < 0) {
-      if (err == -EAGAIN || err == -EWOULDBLOCK)
+      if (err == -EAGAIN || err == -EWOULDBLOCK) {
+        uv__io_drained(w, UV__POLLIN);
         return;  /* Not an error. */
+      }
 
       if (err == -ECONNABORTED)
         continue;  /* Ignore. Nothing we can do about that. */
 
       if (err == -EMFILE || err == -ENFILE) {
         err = uv__emfile_trick(loop, uv__stream_fd(stream));
-        if (err == -EAGAIN || err == -EWOULDBLOCK)
+        if (err == -EAGAIN || err == -EWOULDBLOCK) {
+          uv__io_drained(w, UV__POLLIN);
           break;
+        }
       }
 
       stream->connection_cb(stream, err);
@@ -896,6 +901,9 @@ start:
   /* Either we've counted n down to zero or we've got EAGAIN. */
   assert(n == 0 || n == -1);
 
+  if (n == -1)
+    uv__io_drained(&stream->io_watcher, UV__POLLOUT);
+
   /* Only non-blocking streams should use the write_watcher. */
   assert(!(stream->flags & UV_STREAM_BLOCKING));
 
@@ -1084,7 +1092,8 @@ static void uv__read(uv_stream_t* stream) {
   stream->flags &= ~UV_STREAM_READ_PARTIAL;
 
   /* Prevent loop starvation when the data comes in as fast as (or faster than)
-   * we can read it. XXX Need to rearm fd if we switch to edge-triggered I/O.
+   * we can read it. In edge-triggered mode the watcher stays on the loop's
+   * ready queue until read() returns EAGAIN.
    */
   count = 32;
 
@@ -1134,6 +1143,7 @@ static void uv__read(uv_stream_t* stream) {
       /* Error */
       if (errno == EAGAIN || errno == EWOULDBLOCK) {
         /* Wait for the next one. */
+        uv__io_drained(&stream->io_watcher, UV__POLLIN);
         if (stream->flags & UV_STREAM_READING) {
           uv__io_start(stream->loop, &stream->io_watcher, UV__POLLIN);
           uv__stream_osx_interrupt_select(stream);
@@ -1170,6 +1180,12 @@ static void uv__read(uv_stream_t* stream) {
       /* Return if we didn't fill the buffer, there is no more data to read. */
       if (nread < buflen) {
         stream->flags |= UV_STREAM_READ_PARTIAL;
+        /* That holds for sockets and pipes: new data is a new edge.  Reads
+         * from a tty stop at the end of the line and reads from an ipc pipe
+         * stop at a file descriptor, those still need to see EAGAIN.
+         */
+        if (stream->type != UV_TTY && !is_ipc)
+          uv__io_drained(&stream->io_watcher, UV__POLLIN);
         return;
       }
     }
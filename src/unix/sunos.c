@@ -126,6 +126,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
   sigset_t set;
   uint64_t base;
   uint64_t diff;
+  uint64_t idle_start;
   unsigned int nfds;
   unsigned int i;
   int saved_errno;
@@ -176,6 +177,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     nfds = 1;
     saved_errno = 0;
 
+    idle_start = uv__metrics_poll_start(loop, timeout);
+
     if (pset != NULL)
       pthread_sigmask(SIG_BLOCK, pset, NULL);
 
@@ -188,6 +191,8 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     if (pset != NULL)
       pthread_sigmask(SIG_UNBLOCK, pset, NULL);
 
+    SAVE_ERRNO(uv__metrics_poll_end(loop, idle_start));
+
     if (err) {
       /* Work around another kernel bug: port_getn() may return events even
        * on error.
@@ -253,6 +258,7 @@ void uv__io_poll(uv_loop_t* loop, int timeout) {
     }
     loop->watchers[loop->nwatchers] = NULL;
     loop->watchers[loop->nwatchers + 1] = NULL;
+    uv__metrics_events(loop, nevents);
 
     if (nevents != 0) {
       if (nfds == ARRAY_SIZE(events) && --count != 0) {
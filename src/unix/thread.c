@@ -25,9 +25,16 @@
 #include <pthread.h>
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>  /* PTHREAD_STACK_MIN */
+#include <string.h>
+#include <unistd.h>
 
 #include <sys/time.h>
 
+#if defined(__FreeBSD__)
+# include <pthread_np.h>
+#endif
+
 #undef NANOSEC
 #define NANOSEC ((uint64_t) 1e9)
 
@@ -35,9 +42,27 @@
 struct thread_ctx {
   void (*entry)(void* arg);
   void* arg;
+  char name[64];
 };
 
 
+static void uv__thread_setname(const char* name) {
+#if defined(__linux__)
+  char buf[16];  /* The kernel limit, including the nul byte. */
+
+  strncpy(buf, name, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+  pthread_setname_np(pthread_self(), buf);
+#elif defined(__APPLE__)
+  pthread_setname_np(name);
+#elif defined(__FreeBSD__)
+  pthread_set_name_np(pthread_self(), name);
+#else
+  (void) name;
+#endif
+}
+
+
 static void* uv__thread_start(void *arg)
 {
   struct thread_ctx *ctx_p;
@@ -46,29 +71,165 @@ static void* uv__thread_start(void *arg)
   ctx_p = arg;
   ctx = *ctx_p;
   uv__free(ctx_p);
+
+  if (ctx.name[0] != '\0')
+    uv__thread_setname(ctx.name);
+
   ctx.entry(ctx.arg);
 
   return 0;
 }
 
 
+#if defined(__linux__)
+static int uv__cpumask_to_set(const char* cpumask,
+                              size_t mask_size,
+                              cpu_set_t* set) {
+  size_t i;
+
+  if (cpumask == NULL || mask_size == 0)
+    return -EINVAL;
+
+  CPU_ZERO(set);
+  for (i = 0; i < mask_size; i++) {
+    if (cpumask[i] == 0)
+      continue;
+    if (i >= CPU_SETSIZE)
+      return -EINVAL;
+    CPU_SET(i, set);
+  }
+
+  if (CPU_COUNT(set) == 0)
+    return -EINVAL;
+
+  return 0;
+}
+#endif
+
+
+int uv_cpumask_size(void) {
+#if defined(__linux__)
+  return CPU_SETSIZE;
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+int uv_thread_setaffinity(uv_thread_t* tid,
+                          const char* cpumask,
+                          size_t mask_size) {
+#if defined(__linux__)
+  cpu_set_t set;
+  int err;
+
+  err = uv__cpumask_to_set(cpumask, mask_size, &set);
+  if (err)
+    return err;
+
+  return -pthread_setaffinity_np(*tid, sizeof(set), &set);
+#else
+  return -ENOTSUP;
+#endif
+}
+
+
+static int uv__thread_attr_init(pthread_attr_t* attr,
+                                const uv_thread_options_t* params) {
+  size_t pagesize;
+  size_t stack_size;
+  int err;
+#if defined(__linux__)
+  cpu_set_t set;
+#endif
+
+  err = pthread_attr_init(attr);
+  if (err)
+    return -err;
+
+  if (params->flags & UV_THREAD_HAS_STACK_SIZE) {
+    /* Round up to the nearest page boundary, the minimum that pthreads
+     * accepts depends on the platform and libc.
+     */
+    pagesize = (size_t) getpagesize();
+    stack_size = (params->stack_size + pagesize - 1) &~ (pagesize - 1);
+#ifdef PTHREAD_STACK_MIN
+    if (stack_size < (size_t) PTHREAD_STACK_MIN)
+      stack_size = PTHREAD_STACK_MIN;
+#endif
+    err = -pthread_attr_setstacksize(attr, stack_size);
+    if (err)
+      goto fail;
+  }
+
+  if (params->flags & UV_THREAD_HAS_AFFINITY) {
+#if defined(__linux__)
+    err = uv__cpumask_to_set(params->cpumask, params->mask_size, &set);
+    if (err == 0)
+      err = -pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+#else
+    err = -ENOTSUP;
+#endif
+    if (err)
+      goto fail;
+  }
+
+  return 0;
+
+fail:
+  pthread_attr_destroy(attr);
+  return err;
+}
+
+
 int uv_thread_create(uv_thread_t *tid, void (*entry)(void *arg), void *arg) {
+  return uv_thread_create_ex(tid, NULL, entry, arg);
+}
+
+
+int uv_thread_create_ex(uv_thread_t* tid,
+                        const uv_thread_options_t* params,
+                        void (*entry)(void *arg),
+                        void* arg) {
   struct thread_ctx* ctx;
+  pthread_attr_t attr;
+  pthread_attr_t* attr_p;
   int err;
 
+  attr_p = NULL;
+  if (params != NULL && params->flags != UV_THREAD_NO_FLAGS) {
+    err = uv__thread_attr_init(&attr, params);
+    if (err)
+      return err;
+    attr_p = &attr;
+  }
+
   ctx = uv__malloc(sizeof(*ctx));
-  if (ctx == NULL)
-    return UV_ENOMEM;
+  if (ctx == NULL) {
+    err = -ENOMEM;
+    goto out;
+  }
 
   ctx->entry = entry;
   ctx->arg = arg;
+  ctx->name[0] = '\0';
+  if (params != NULL &&
+      (params->flags & UV_THREAD_HAS_NAME) &&
+      params->name != NULL) {
+    strncpy(ctx->name, params->name, sizeof(ctx->name) - 1);
+    ctx->name[sizeof(ctx->name) - 1] = '\0';
+  }
 
-  err = pthread_create(tid, NULL, uv__thread_start, ctx);
+  err = -pthread_create(tid, attr_p, uv__thread_start, ctx);
 
   if (err)
     uv__free(ctx);
 
-  return -err;
+out:
+  if (attr_p != NULL)
+    pthread_attr_destroy(attr_p);
+
+  return err;
 }
 
 
@@ -0,0 +1,354 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "internal.h"
+
+/* Hierarchical timing wheel, selected with UV_LOOP_TIMER_WHEEL.
+ *
+ * Level L has 64 slots that are 64^L milliseconds wide.  A timer goes into
+ * the level of the most significant bit in which its expiry differs from
+ * wheel->now, so every timer in a level shares the bits above that level
+ * with wheel->now and the slot index alone orders the slots.  When wheel->now
+ * enters the block of a non-empty slot, its timers cascade down a level,
+ * until they reach the expired list.  Six levels cover 2^36 ms, a bit over
+ * two years; timers beyond that wait on an overflow list.
+ *
+ * Timers in a level 0 slot share their expiry, but cascaded and freshly
+ * started timers can end up in the same slot in any order.  They are moved
+ * to the expired list ordered by start_id, the same order as the heap that
+ * is used by default.
+ *
+ * A timer keeps its queue links in heap_node[0..1] and the list it is on in
+ * heap_node[2].
+ */
+#define UV__WHEEL_BITS 6
+#define UV__WHEEL_SIZE (1 << UV__WHEEL_BITS)
+#define UV__WHEEL_MASK (UV__WHEEL_SIZE - 1)
+#define UV__WHEEL_LEVELS 6
+#define UV__WHEEL_SPAN (UV__WHEEL_BITS * UV__WHEEL_LEVELS)
+
+#define UV__TIMER_QUEUE(handle) ((QUEUE*) (handle)->heap_node)
+#define UV__TIMER_LIST(handle) ((QUEUE*) (handle)->heap_node[2])
+
+struct uv__timer_wheel {
+  uint64_t now;
+  uint64_t count;  /* Timers in slots or on the overflow list. */
+  uint64_t occupied[UV__WHEEL_LEVELS];
+  QUEUE slots[UV__WHEEL_LEVELS][UV__WHEEL_SIZE];
+  QUEUE overflow;
+  QUEUE expired;
+};
+
+
+static unsigned int uv__wheel_fls(uint64_t value) {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(value);
+#else
+  unsigned int n;
+
+  for (n = 0; value >>= 1; n++);
+  return n;
+#endif
+}
+
+
+static unsigned int uv__wheel_ffs(uint64_t value) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(value);
+#else
+  unsigned int n;
+
+  for (n = 0; (value & 1) == 0; n++)
+    value >>= 1;
+  return n;
+#endif
+}
+
+
+static void uv__wheel_link(QUEUE* list, uv_timer_t* handle) {
+  QUEUE_INSERT_TAIL(list, UV__TIMER_QUEUE(handle));
+  handle->heap_node[2] = list;
+}
+
+
+/* Keeps timers with the same expiry in start_id order.  Timers started from
+ * a callback have the highest start_id and stop the scan right away.
+ */
+static void uv__wheel_expire(struct uv__timer_wheel* wheel,
+                             uv_timer_t* handle) {
+  uv_timer_t* prev;
+  QUEUE* q;
+
+  for (q = QUEUE_PREV(&wheel->expired); q != &wheel->expired;
+       q = QUEUE_PREV(q)) {
+    prev = QUEUE_DATA(q, uv_timer_t, heap_node);
+    if (prev->timeout != handle->timeout || prev->start_id < handle->start_id)
+      break;
+  }
+
+  /* Insert after q. */
+  QUEUE_INSERT_HEAD(q, UV__TIMER_QUEUE(handle));
+  handle->heap_node[2] = &wheel->expired;
+}
+
+
+static void uv__wheel_place(struct uv__timer_wheel* wheel,
+                            uv_timer_t* handle) {
+  unsigned int level;
+  unsigned int index;
+
+  if (handle->timeout <= wheel->now) {
+    uv__wheel_expire(wheel, handle);
+    return;
+  }
+
+  wheel->count++;
+  level = uv__wheel_fls(handle->timeout ^ wheel->now) / UV__WHEEL_BITS;
+  if (level >= UV__WHEEL_LEVELS) {
+    uv__wheel_link(&wheel->overflow, handle);
+    return;
+  }
+
+  index = (handle->timeout >> (level * UV__WHEEL_BITS)) & UV__WHEEL_MASK;
+  uv__wheel_link(&wheel->slots[level][index], handle);
+  wheel->occupied[level] |= (uint64_t) 1 << index;
+}
+
+
+static void uv__wheel_unlink(struct uv__timer_wheel* wheel,
+                             uv_timer_t* handle) {
+  QUEUE* list;
+  size_t n;
+
+  list = UV__TIMER_LIST(handle);
+  QUEUE_REMOVE(UV__TIMER_QUEUE(handle));
+
+  if (list == &wheel->expired)
+    return;
+
+  wheel->count--;
+  if (list == &wheel->overflow || !QUEUE_EMPTY(list))
+    return;
+
+  n = list - &wheel->slots[0][0];
+  wheel->occupied[n / UV__WHEEL_SIZE] &=
+      ~((uint64_t) 1 << (n % UV__WHEEL_SIZE));
+}
+
+
+/* Moves every timer on the list to where it belongs relative to the
+ * current wheel->now.  Timers on the overflow list can land on it again,
+ * hence the count.
+ */
+static void uv__wheel_replace(struct uv__timer_wheel* wheel, QUEUE* list) {
+  uv_timer_t* handle;
+  uint64_t n;
+  QUEUE* q;
+
+  n = 0;
+  QUEUE_FOREACH(q, list)
+    n++;
+
+  while (n-- > 0) {
+    q = QUEUE_HEAD(list);
+    QUEUE_REMOVE(q);
+    handle = QUEUE_DATA(q, uv_timer_t, heap_node);
+    wheel->count--;
+    uv__wheel_place(wheel, handle);
+  }
+}
+
+
+/* The first time at which a slot has to be cascaded or expired, or
+ * UINT64_MAX if the wheel is empty.  Level 0 gives the exact expiry, the
+ * higher levels only a lower bound.
+ */
+static uint64_t uv__wheel_next_event(const struct uv__timer_wheel* wheel) {
+  unsigned int level;
+  unsigned int shift;
+  unsigned int index;
+  uint64_t bits;
+
+  for (level = 0; level < UV__WHEEL_LEVELS; level++) {
+    shift = level * UV__WHEEL_BITS;
+    index = (wheel->now >> shift) & UV__WHEEL_MASK;
+    /* Only slots after the current one can be occupied, a timer in the
+     * current one would have been placed in a lower level.
+     */
+    bits = wheel->occupied[level] & ~(((uint64_t) 2 << index) - 1);
+    if (bits != 0) {
+      shift += UV__WHEEL_BITS;
+      return (wheel->now >> shift << shift) |
+             ((uint64_t) uv__wheel_ffs(bits) << (shift - UV__WHEEL_BITS));
+    }
+  }
+
+  if (!QUEUE_EMPTY(&wheel->overflow))
+    return ((wheel->now >> UV__WHEEL_SPAN) + 1) << UV__WHEEL_SPAN;
+
+  return (uint64_t) -1;
+}
+
+
+static void uv__wheel_tick(struct uv__timer_wheel* wheel) {
+  unsigned int level;
+  unsigned int shift;
+  uv_timer_t* handle;
+  QUEUE* slot;
+  QUEUE* q;
+
+  if ((wheel->now & (((uint64_t) 1 << UV__WHEEL_SPAN) - 1)) == 0)
+    uv__wheel_replace(wheel, &wheel->overflow);
+
+  for (level = UV__WHEEL_LEVELS - 1; level > 0; level--) {
+    shift = level * UV__WHEEL_BITS;
+    if (wheel->now & (((uint64_t) 1 << shift) - 1))
+      continue;
+
+    slot = &wheel->slots[level][(wheel->now >> shift) & UV__WHEEL_MASK];
+    wheel->occupied[level] &=
+        ~((uint64_t) 1 << ((wheel->now >> shift) & UV__WHEEL_MASK));
+    uv__wheel_replace(wheel, slot);
+  }
+
+  slot = &wheel->slots[0][wheel->now & UV__WHEEL_MASK];
+  wheel->occupied[0] &= ~((uint64_t) 1 << (wheel->now & UV__WHEEL_MASK));
+
+  while (!QUEUE_EMPTY(slot)) {
+    q = QUEUE_HEAD(slot);
+    QUEUE_REMOVE(q);
+    handle = QUEUE_DATA(q, uv_timer_t, heap_node);
+    wheel->count--;
+    uv__wheel_expire(wheel, handle);
+  }
+}
+
+
+/* Advances wheel->now towards `target` but stops at the first tick that
+ * expires timers, so that callbacks run in expiry order even when a callback
+ * starts a timer that is due before `target`.
+ */
+static void uv__wheel_advance(struct uv__timer_wheel* wheel, uint64_t target) {
+  uint64_t next;
+
+  while (QUEUE_EMPTY(&wheel->expired) && wheel->now < target) {
+    if (wheel->count == 0) {
+      wheel->now = target;
+      break;
+    }
+
+    /* Nothing is due between now and next, so it's safe to skip ahead. */
+    next = uv__wheel_next_event(wheel);
+    if (next > target) {
+      wheel->now = target;
+      break;
+    }
+
+    wheel->now = next;
+    uv__wheel_tick(wheel);
+  }
+}
+
+
+int uv__timer_wheel_init(uv_loop_t* loop) {
+  struct uv__timer_wheel* wheel;
+  unsigned int level;
+  unsigned int index;
+
+  if (loop->timer_wheel != NULL)
+    return 0;
+
+  /* Timers already in the heap would be lost. */
+  if (loop->timer_heap.nelts != 0)
+    return -EBUSY;
+
+  wheel = uv__malloc(sizeof(*wheel));
+  if (wheel == NULL)
+    return -ENOMEM;
+
+  wheel->now = loop->time;
+  wheel->count = 0;
+  for (level = 0; level < UV__WHEEL_LEVELS; level++) {
+    wheel->occupied[level] = 0;
+    for (index = 0; index < UV__WHEEL_SIZE; index++)
+      QUEUE_INIT(&wheel->slots[level][index]);
+  }
+  QUEUE_INIT(&wheel->overflow);
+  QUEUE_INIT(&wheel->expired);
+
+  loop->timer_wheel = wheel;
+  return 0;
+}
+
+
+void uv__timer_wheel_delete(uv_loop_t* loop) {
+  uv__free(loop->timer_wheel);
+  loop->timer_wheel = NULL;
+}
+
+
+void uv__timer_wheel_insert(uv_loop_t* loop, uv_timer_t* handle) {
+  struct uv__timer_wheel* wheel;
+
+  wheel = loop->timer_wheel;
+
+  /* Catch up in one step when there is nothing to cascade. */
+  if (wheel->count == 0 && wheel->now < loop->time)
+    wheel->now = loop->time;
+
+  uv__wheel_place(wheel, handle);
+}
+
+
+void uv__timer_wheel_remove(uv_loop_t* loop, uv_timer_t* handle) {
+  uv__wheel_unlink(loop->timer_wheel, handle);
+}
+
+
+uv_timer_t* uv__timer_wheel_due(uv_loop_t* loop) {
+  struct uv__timer_wheel* wheel;
+
+  wheel = loop->timer_wheel;
+  uv__wheel_advance(wheel, loop->time);
+
+  if (QUEUE_EMPTY(&wheel->expired))
+    return NULL;
+
+  return QUEUE_DATA(QUEUE_HEAD(&wheel->expired), uv_timer_t, heap_node);
+}
+
+
+int uv__timer_wheel_next(const uv_loop_t* loop, uint64_t* timeout) {
+  const struct uv__timer_wheel* wheel;
+
+  wheel = loop->timer_wheel;
+  if (!QUEUE_EMPTY(&wheel->expired)) {
+    *timeout = wheel->now;
+    return 0;
+  }
+
+  if (wheel->count == 0)
+    return -1;
+
+  *timeout = uv__wheel_next_event(wheel);
+  return 0;
+}
@@ -20,41 +20,23 @@
 
 #include "uv.h"
 #include "internal.h"
-#include "heap-inl.h"
+#include "dheap-inl.h"
 
 #include <assert.h>
 #include <limits.h>
 
-
-static int timer_less_than(const struct heap_node* ha,
-                           const struct heap_node* hb) {
-  const uv_timer_t* a;
-  const uv_timer_t* b;
-
-  a = container_of(ha, const uv_timer_t, heap_node);
-  b = container_of(hb, const uv_timer_t, heap_node);
-
-  if (a->timeout < b->timeout)
-    return 1;
-  if (b->timeout < a->timeout)
-    return 0;
-
-  /* Compare start_id when both have the same timeout. start_id is
-   * allocated with loop->timer_counter in uv_timer_start().
-   */
-  if (a->start_id < b->start_id)
-    return 1;
-  if (b->start_id < a->start_id)
-    return 0;
-
-  return 0;
-}
+/* The heap keeps its own copy of timeout and start_id, the handle only
+ * stores its position in the heap, in heap_node[0].
+ */
+#define UV__TIMER_NODE(handle) ((struct dheap_node*) (handle)->heap_node)
+#define UV__TIMER_HANDLE(node) container_of((void*) (node), uv_timer_t, heap_node)
 
 
 int uv_timer_init(uv_loop_t* loop, uv_timer_t* handle) {
   uv__handle_init(loop, (uv_handle_t*)handle, UV_TIMER);
   handle->timer_cb = NULL;
   handle->repeat = 0;
+  handle->slack = 0;
   return 0;
 }
 
@@ -64,29 +46,97 @@ int uv_timer_start(uv_timer_t* handle,
                    uint64_t timeout,
                    uint64_t repeat) {
   uint64_t clamped_timeout;
+  int err;
 
   if (cb == NULL)
     return -EINVAL;
 
+  /* Make sure the insert below can't fail before the handle is touched, a
+   * failed start leaves the timer as it was.
+   */
+  if (handle->loop->timer_wheel == NULL) {
+    err = dheap_reserve((struct dheap*) &handle->loop->timer_heap, 1);
+    if (err)
+      return err;
+  }
+
   if (uv__is_active(handle))
     uv_timer_stop(handle);
 
+  handle->flags &= ~UV_TIMER_NS;
   clamped_timeout = handle->loop->time + timeout;
   if (clamped_timeout < timeout)
     clamped_timeout = (uint64_t) -1;
 
   handle->timer_cb = cb;
-  handle->timeout = clamped_timeout;
+  handle->timeout = uv__timer_slack_due(clamped_timeout, handle->slack);
   handle->repeat = repeat;
   /* start_id is the second index to be compared in uv__timer_cmp() */
   handle->start_id = handle->loop->timer_counter++;
 
-  heap_insert((struct heap*) &handle->loop->timer_heap,
-              (struct heap_node*) &handle->heap_node,
-              timer_less_than);
+  if (handle->loop->timer_wheel != NULL) {
+    uv__timer_wheel_insert(handle->loop, handle);
+  } else {
+    err = dheap_insert((struct dheap*) &handle->loop->timer_heap,
+                       UV__TIMER_NODE(handle),
+                       handle->timeout,
+                       handle->start_id);
+    assert(err == 0);
+  }
+  uv__handle_start(handle);
+
+  return 0;
+}
+
+
+int uv_timer_start_ns(uv_timer_t* handle,
+                      uv_timer_cb cb,
+                      uint64_t timeout,
+                      uint64_t repeat) {
+#if defined(__linux__)
+  uv_loop_t* loop;
+  uint64_t clamped_timeout;
+  int err;
+
+  if (cb == NULL)
+    return -EINVAL;
+
+  loop = handle->loop;
+  clamped_timeout = uv__hrtime(UV_CLOCK_PRECISE) + timeout;
+  if (clamped_timeout < timeout)
+    clamped_timeout = (uint64_t) -1;
+
+  /* Everything that can fail comes before the handle is touched.  A deadline
+   * that ends up unused only costs a spurious wakeup.
+   */
+  err = dheap_reserve((struct dheap*) &loop->hrtimer_heap, 1);
+  if (err)
+    return err;
+
+  err = uv__hrtimer_arm(loop, clamped_timeout);
+  if (err)
+    return err;
+
+  if (uv__is_active(handle))
+    uv_timer_stop(handle);
+
+  handle->flags |= UV_TIMER_NS;
+  handle->timer_cb = cb;
+  handle->timeout = clamped_timeout;
+  handle->repeat = repeat;
+  handle->start_id = loop->timer_counter++;
+
+  err = dheap_insert((struct dheap*) &loop->hrtimer_heap,
+                     UV__TIMER_NODE(handle),
+                     handle->timeout,
+                     handle->start_id);
+  assert(err == 0);
   uv__handle_start(handle);
 
   return 0;
+#else
+  return -ENOSYS;
+#endif
 }
 
 
@@ -94,9 +144,20 @@ int uv_timer_stop(uv_timer_t* handle) {
   if (!uv__is_active(handle))
     return 0;
 
-  heap_remove((struct heap*) &handle->loop->timer_heap,
-              (struct heap_node*) &handle->heap_node,
-              timer_less_than);
+#if defined(__linux__)
+  if (handle->flags & UV_TIMER_NS) {
+    dheap_remove((struct dheap*) &handle->loop->hrtimer_heap,
+                 UV__TIMER_NODE(handle));
+    uv__handle_stop(handle);
+    return 0;
+  }
+#endif
+
+  if (handle->loop->timer_wheel != NULL)
+    uv__timer_wheel_remove(handle->loop, handle);
+  else
+    dheap_remove((struct dheap*) &handle->loop->timer_heap,
+                 UV__TIMER_NODE(handle));
   uv__handle_stop(handle);
 
   return 0;
@@ -107,12 +168,17 @@ int uv_timer_again(uv_timer_t* handle) {
   if (handle->timer_cb == NULL)
     return -EINVAL;
 
-  if (handle->repeat) {
-    uv_timer_stop(handle);
-    uv_timer_start(handle, handle->timer_cb, handle->repeat, handle->repeat);
-  }
+  if (handle->repeat == 0)
+    return 0;
 
-  return 0;
+  /* Starting stops the timer first.  If it fails, the timer is unchanged. */
+  if (handle->flags & UV_TIMER_NS)
+    return uv_timer_start_ns(handle,
+                             handle->timer_cb,
+                             handle->repeat,
+                             handle->repeat);
+
+  return uv_timer_start(handle, handle->timer_cb, handle->repeat, handle->repeat);
 }
 
 
@@ -126,20 +192,37 @@ uint64_t uv_timer_get_repeat(const uv_timer_t* handle) {
 }
 
 
+void uv_timer_set_slack(uv_timer_t* handle, uint64_t slack) {
+  handle->slack = slack;
+}
+
+
+uint64_t uv_timer_get_slack(const uv_timer_t* handle) {
+  return handle->slack;
+}
+
+
 int uv__next_timeout(const uv_loop_t* loop) {
-  const struct heap_node* heap_node;
-  const uv_timer_t* handle;
+  const struct dheap* heap;
+  uint64_t timeout;
   uint64_t diff;
 
-  heap_node = heap_min((const struct heap*) &loop->timer_heap);
-  if (heap_node == NULL)
-    return -1; /* block indefinitely */
+  if (loop->timer_wheel != NULL) {
+    /* May wake up early to cascade timers, but never late. */
+    if (uv__timer_wheel_next(loop, &timeout))
+      return -1; /* block indefinitely */
+  } else {
+    heap = (const struct dheap*) &loop->timer_heap;
+    if (heap->nelts == 0)
+      return -1; /* block indefinitely */
 
-  handle = container_of(heap_node, const uv_timer_t, heap_node);
-  if (handle->timeout <= loop->time)
+    timeout = heap->entries[0].key;
+  }
+
+  if (timeout <= loop->time)
     return 0;
 
-  diff = handle->timeout - loop->time;
+  diff = timeout - loop->time;
   if (diff > INT_MAX)
     diff = INT_MAX;
 
@@ -147,24 +230,87 @@ int uv__next_timeout(const uv_loop_t* loop) {
 }
 
 
+/* How late the timer is, measured with a clock that's more precise than
+ * loop->time.
+ */
+static void uv__timer_lag(uv_loop_t* loop, uint64_t timeout) {
+  uint64_t now;
+
+  now = uv__hrtime(UV_CLOCK_PRECISE);
+  if (now < timeout * 1000000)
+    now = timeout * 1000000;
+
+  uv__lag_record(loop, UV_LAG_TIMER, now - timeout * 1000000);
+}
+
+
 void uv__run_timers(uv_loop_t* loop) {
-  struct heap_node* heap_node;
+  struct dheap_node* node;
   uv_timer_t* handle;
 
   for (;;) {
-    heap_node = heap_min((struct heap*) &loop->timer_heap);
-    if (heap_node == NULL)
-      break;
+    if (loop->timer_wheel != NULL) {
+      handle = uv__timer_wheel_due(loop);
+      if (handle == NULL)
+        break;
+    } else {
+      node = dheap_min((struct dheap*) &loop->timer_heap);
+      if (node == NULL)
+        break;
+
+      handle = UV__TIMER_HANDLE(node);
+      if (handle->timeout > loop->time)
+        break;
+    }
+
+    if (loop->lag != NULL)
+      uv__timer_lag(loop, handle->timeout);
+
+    /* Stopping frees the timer's slot in the heap, restarting can't fail. */
+    uv_timer_stop(handle);
+    uv_timer_again(handle);
+    loop->metrics.callbacks++;
+    handle->timer_cb(handle);
+  }
+}
+
 
-    handle = container_of(heap_node, uv_timer_t, heap_node);
-    if (handle->timeout > loop->time)
+#if defined(__linux__)
+/* Runs from the timerfd watcher in the poll phase of the loop. */
+void uv__run_hrtimers(uv_loop_t* loop) {
+  struct dheap_node* node;
+  uv_timer_t* handle;
+  uint64_t now;
+
+  /* Timers that a callback starts with a zero timeout wait for the next
+   * round, or a repeating 0 ns timer would never let go of the loop.
+   */
+  now = uv__hrtime(UV_CLOCK_PRECISE);
+
+  for (;;) {
+    node = dheap_min((struct dheap*) &loop->hrtimer_heap);
+    if (node == NULL)
+      return;
+
+    handle = UV__TIMER_HANDLE(node);
+    if (handle->timeout > now)
       break;
 
+    if (loop->lag != NULL)
+      uv__lag_record(loop, UV_LAG_TIMER, now - handle->timeout);
+
     uv_timer_stop(handle);
     uv_timer_again(handle);
+    loop->metrics.callbacks++;
     handle->timer_cb(handle);
   }
+
+  /* Can only fail if timerfd_settime() does, which it doesn't with a valid
+   * fd and absolute time.
+   */
+  uv__hrtimer_arm(loop, handle->timeout);
 }
+#endif
 
 
 void uv__timer_close(uv_timer_t* handle) {
@@ -157,7 +157,8 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
   assert(handle->alloc_cb != NULL);
 
   /* Prevent loop starvation when the data comes in as fast as (or faster than)
-   * we can read it. XXX Need to rearm fd if we switch to edge-triggered I/O.
+   * we can read it. In edge-triggered mode the watcher stays on the loop's
+   * ready queue until recvmsg() returns EAGAIN.
    */
   count = 32;
 
@@ -182,10 +183,12 @@ static void uv__udp_recvmsg(uv_udp_t* handle) {
     while (nread == -1 && errno == EINTR);
 
     if (nread == -1) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK)
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        uv__io_drained(&handle->io_watcher, UV__POLLIN);
         handle->recv_cb(handle, 0, &buf, NULL, 0);
-      else
+      } else {
         handle->recv_cb(handle, -errno, &buf, NULL, 0);
+      }
     }
     else {
       const struct sockaddr *addr;
@@ -233,8 +236,10 @@ static void uv__udp_sendmsg(uv_udp_t* handle) {
       size = sendmsg(handle->io_watcher.fd, &h, 0);
     } while (size == -1 && errno == EINTR);
 
-    if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      uv__io_drained(&handle->io_watcher, UV__POLLOUT);
       break;
+    }
 
     req->status = (size == -1 ? -errno : size);
 
@@ -284,7 +289,7 @@ int uv__udp_bind(uv_udp_t* handle,
   int fd;
 
   /* Check for bad flags. */
-  if (flags & ~(UV_UDP_IPV6ONLY | UV_UDP_REUSEADDR))
+  if (flags & ~(UV_UDP_IPV6ONLY | UV_UDP_REUSEADDR | UV_UDP_REUSEPORT))
     return -EINVAL;
 
   /* Cannot set IPv6-only mode on non-IPv6 socket. */
@@ -306,6 +311,12 @@ int uv__udp_bind(uv_udp_t* handle,
       goto out;
   }
 
+  if (flags & UV_UDP_REUSEPORT) {
+    err = uv__sock_reuseport(fd);
+    if (err)
+      goto out;
+  }
+
   if (flags & UV_UDP_IPV6ONLY) {
 #ifdef IPV6_V6ONLY
     yes = 1;
@@ -455,10 +466,11 @@ int uv__udp_try_send(uv_udp_t* handle,
   } while (size == -1 && errno == EINTR);
 
   if (size == -1) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK)
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      uv__io_drained(&handle->io_watcher, UV__POLLOUT);
       return -EAGAIN;
-    else
-      return -errno;
+    }
+    return -errno;
   }
 
   return size;
@@ -558,6 +570,7 @@ int uv_udp_init(uv_loop_t* loop, uv_udp_t* handle) {
   handle->send_queue_size = 0;
   handle->send_queue_count = 0;
   uv__io_init(&handle->io_watcher, uv__udp_io, -1);
+  uv__io_allow_edge(&handle->io_watcher);
   QUEUE_INIT(&handle->write_queue);
   QUEUE_INIT(&handle->write_completed_queue);
   return 0;
@@ -409,6 +409,15 @@ uint64_t uv_now(const uv_loop_t* loop) {
 }
 
 
+uint64_t uv_now_ns(const uv_loop_t* loop) {
+#ifdef _WIN32
+  return loop->time * 1000000;
+#else
+  return loop->time_ns;
+#endif
+}
+
+
 
 size_t uv__count_bufs(const uv_buf_t bufs[], unsigned int nbufs) {
   unsigned int i;
@@ -421,6 +430,28 @@ size_t uv__count_bufs(const uv_buf_t bufs[], unsigned int nbufs) {
   return bytes;
 }
 
+/* Rounds the due time of a timer up to a multiple of the largest power of two
+ * that fits in its slack.  Timers with similar slack end up on the same
+ * boundaries and expire together, also across loops since the loop time of
+ * every loop is derived from the same monotonic clock.
+ */
+uint64_t uv__timer_slack_due(uint64_t due, uint64_t slack) {
+  uint64_t granularity;
+  uint64_t rounded;
+
+  if (slack == 0)
+    return due;
+
+  for (granularity = 1; granularity <= slack / 2; granularity <<= 1);
+
+  rounded = (due + granularity - 1) & ~(granularity - 1);
+  if (rounded < due)
+    return due;  /* Overflow, the timer is infinitely far off anyway. */
+
+  return rounded;
+}
+
+
 int uv_recv_buffer_size(uv_handle_t* handle, int* value) {
   return uv__socket_sockopt(handle, SO_RCVBUF, value);
 }
@@ -108,13 +108,29 @@ int uv__getaddrinfo_translate_error(int sys_err);    /* EAI_* error. */
 
 void uv__work_submit(uv_loop_t* loop,
                      struct uv__work *w,
+                     uv_work_kind kind,
                      void (*work)(struct uv__work *w),
                      void (*done)(struct uv__work *w, int status));
 
+void uv__work_submit_list(uv_loop_t* loop,
+                          QUEUE* list,
+                          unsigned int n,
+                          uv_work_kind kind,
+                          void (*work)(struct uv__work *w),
+                          void (*done)(struct uv__work *w, int status));
+
+void uv__work_submit_serial(uv_serial_t* serial,
+                            struct uv__work *w,
+                            uv_work_kind kind,
+                            void (*work)(struct uv__work *w),
+                            void (*done)(struct uv__work *w, int status));
+
 void uv__work_done(uv_async_t* handle);
 
 size_t uv__count_bufs(const uv_buf_t bufs[], unsigned int nbufs);
 
+uint64_t uv__timer_slack_due(uint64_t due, uint64_t slack);
+
 int uv__socket_sockopt(uv_handle_t* handle, int optname, int* value);
 
 void uv__fs_scandir_cleanup(uv_fs_t* req);
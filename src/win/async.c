@@ -97,3 +97,15 @@ void uv_process_async_wakeup_req(uv_loop_t* loop, uv_async_t* handle,
     handle->async_cb(handle);
   }
 }
+
+
+int uv_channel_init(uv_loop_t* loop,
+                    uv_channel_t* channel,
+                    unsigned int capacity) {
+  return UV_ENOSYS;
+}
+
+
+int uv_channel_send(uv_channel_t* channel, uv_channel_cb cb, void* arg) {
+  return UV_ENOSYS;
+}
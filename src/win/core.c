@@ -139,6 +139,8 @@ int uv_loop_init(uv_loop_t* loop) {
   uv_update_time(loop);
 
   QUEUE_INIT(&loop->wq);
+  loop->wq_slot = 0;
+  loop->wq_completed = NULL;
   QUEUE_INIT(&loop->handle_queue);
   QUEUE_INIT(&loop->active_reqs);
   loop->active_handles = 0;
@@ -200,6 +202,7 @@ void uv__loop_close(uv_loop_t* loop) {
 
   uv_mutex_lock(&loop->wq_mutex);
   assert(QUEUE_EMPTY(&loop->wq) && "thread pool work queue not empty!");
+  assert(loop->wq_completed == NULL);
   assert(!uv__has_active_reqs(loop));
   uv_mutex_unlock(&loop->wq_mutex);
   uv_mutex_destroy(&loop->wq_mutex);
@@ -213,6 +216,25 @@ int uv__loop_configure(uv_loop_t* loop, uv_loop_option option, va_list ap) {
 }
 
 
+int uv_loop_metrics(const uv_loop_t* loop, uv_metrics_t* metrics) {
+  memset(metrics, 0, sizeof(*metrics));
+  return UV_ENOSYS;
+}
+
+
+int uv_loop_lag(const uv_loop_t* loop,
+                uv_lag_type type,
+                double percentile,
+                uint64_t* value) {
+  return UV_ENOSYS;
+}
+
+
+int uv_loop_lag_reset(uv_loop_t* loop) {
+  return UV_ENOSYS;
+}
+
+
 int uv_backend_fd(const uv_loop_t* loop) {
   return -1;
 }
@@ -442,3 +464,13 @@ int uv__socket_sockopt(uv_handle_t* handle, int optname, int* value) {
 
   return 0;
 }
+
+
+int uv_incoming_cpu(uv_handle_t* handle, int cpu) {
+  return UV_ENOTSUP;
+}
+
+
+int uv_reuseport_steer_cpu(uv_handle_t* handle, unsigned int nsockets) {
+  return UV_ENOTSUP;
+}
@@ -46,7 +46,18 @@
 #define QUEUE_FS_TP_JOB(loop, req)                                          \
   do {                                                                      \
     uv__req_register(loop, req);                                            \
-    uv__work_submit((loop), &(req)->work_req, uv__fs_work, uv__fs_done);    \
+    if ((req)->work_req.serial != NULL)                                     \
+      uv__work_submit_serial((req)->work_req.serial,                        \
+                             &(req)->work_req,                              \
+                             UV_WORK_FAST_IO,                               \
+                             uv__fs_work,                                   \
+                             uv__fs_done);                                  \
+    else                                                                    \
+      uv__work_submit((loop),                                               \
+                      &(req)->work_req,                                     \
+                      UV_WORK_FAST_IO,                                      \
+                      uv__fs_work,                                          \
+                      uv__fs_done);                                         \
   } while (0)
 
 #define SET_REQ_RESULT(req, result_value)                                   \
@@ -230,6 +241,7 @@ INLINE static void uv_fs_req_init(uv_loop_t* loop, uv_fs_t* req,
   req->ptr = NULL;
   req->path = NULL;
   req->cb = cb;
+  req->work_req.serial = NULL;
 }
 
 
@@ -2338,3 +2350,117 @@ int uv_fs_futime(uv_loop_t* loop, uv_fs_t* req, uv_file fd, double atime,
     return req->result;
   }
 }
+
+
+int uv_serial_fs_read(uv_serial_t* serial, uv_fs_t* req, uv_file fd,
+    const uv_buf_t bufs[], unsigned int nbufs, int64_t offset,
+    uv_fs_cb cb) {
+  if (cb == NULL)
+    return UV_EINVAL;
+
+  uv_fs_req_init(serial->loop, req, UV_FS_READ, cb);
+  req->work_req.serial = serial;
+
+  req->file.fd = fd;
+
+  req->fs.info.nbufs = nbufs;
+  req->fs.info.bufs = req->fs.info.bufsml;
+  if (nbufs > ARRAY_SIZE(req->fs.info.bufsml))
+    req->fs.info.bufs = uv__malloc(nbufs * sizeof(*bufs));
+
+  if (req->fs.info.bufs == NULL)
+    return UV_ENOMEM;
+
+  memcpy(req->fs.info.bufs, bufs, nbufs * sizeof(*bufs));
+
+  req->fs.info.offset = offset;
+
+  QUEUE_FS_TP_JOB(serial->loop, req);
+  return 0;
+}
+
+
+int uv_serial_fs_write(uv_serial_t* serial, uv_fs_t* req, uv_file fd,
+    const uv_buf_t bufs[], unsigned int nbufs, int64_t offset,
+    uv_fs_cb cb) {
+  if (cb == NULL)
+    return UV_EINVAL;
+
+  uv_fs_req_init(serial->loop, req, UV_FS_WRITE, cb);
+  req->work_req.serial = serial;
+
+  req->file.fd = fd;
+
+  req->fs.info.nbufs = nbufs;
+  req->fs.info.bufs = req->fs.info.bufsml;
+  if (nbufs > ARRAY_SIZE(req->fs.info.bufsml))
+    req->fs.info.bufs = uv__malloc(nbufs * sizeof(*bufs));
+
+  if (req->fs.info.bufs == NULL)
+    return UV_ENOMEM;
+
+  memcpy(req->fs.info.bufs, bufs, nbufs * sizeof(*bufs));
+
+  req->fs.info.offset = offset;
+
+  QUEUE_FS_TP_JOB(serial->loop, req);
+  return 0;
+}
+
+
+int uv_serial_fs_fsync(uv_serial_t* serial, uv_fs_t* req, uv_file fd,
+    uv_fs_cb cb) {
+  if (cb == NULL)
+    return UV_EINVAL;
+
+  uv_fs_req_init(serial->loop, req, UV_FS_FSYNC, cb);
+  req->work_req.serial = serial;
+  req->file.fd = fd;
+
+  QUEUE_FS_TP_JOB(serial->loop, req);
+  return 0;
+}
+
+
+int uv_serial_fs_fdatasync(uv_serial_t* serial, uv_fs_t* req, uv_file fd,
+    uv_fs_cb cb) {
+  if (cb == NULL)
+    return UV_EINVAL;
+
+  uv_fs_req_init(serial->loop, req, UV_FS_FDATASYNC, cb);
+  req->work_req.serial = serial;
+  req->file.fd = fd;
+
+  QUEUE_FS_TP_JOB(serial->loop, req);
+  return 0;
+}
+
+
+int uv_serial_fs_ftruncate(uv_serial_t* serial, uv_fs_t* req, uv_file fd,
+    int64_t offset, uv_fs_cb cb) {
+  if (cb == NULL)
+    return UV_EINVAL;
+
+  uv_fs_req_init(serial->loop, req, UV_FS_FTRUNCATE, cb);
+  req->work_req.serial = serial;
+
+  req->file.fd = fd;
+  req->fs.info.offset = offset;
+
+  QUEUE_FS_TP_JOB(serial->loop, req);
+  return 0;
+}
+
+
+int uv_serial_fs_close(uv_serial_t* serial, uv_fs_t* req, uv_file fd,
+    uv_fs_cb cb) {
+  if (cb == NULL)
+    return UV_EINVAL;
+
+  uv_fs_req_init(serial->loop, req, UV_FS_CLOSE, cb);
+  req->work_req.serial = serial;
+  req->file.fd = fd;
+
+  QUEUE_FS_TP_JOB(serial->loop, req);
+  return 0;
+}
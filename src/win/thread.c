@@ -145,10 +145,83 @@ static UINT __stdcall uv__thread_start(void* arg) {
 }
 
 
+static int uv__cpumask_to_affinity(const char* cpumask,
+                                   size_t mask_size,
+                                   DWORD_PTR* affinity) {
+  size_t i;
+
+  if (cpumask == NULL || mask_size == 0)
+    return UV_EINVAL;
+
+  *affinity = 0;
+  for (i = 0; i < mask_size; i++) {
+    if (cpumask[i] == 0)
+      continue;
+    if (i >= sizeof(*affinity) * 8)
+      return UV_EINVAL;
+    *affinity |= (DWORD_PTR) 1 << i;
+  }
+
+  if (*affinity == 0)
+    return UV_EINVAL;
+
+  return 0;
+}
+
+
+int uv_cpumask_size(void) {
+  return (int) (sizeof(DWORD_PTR) * 8);
+}
+
+
+int uv_thread_setaffinity(uv_thread_t* tid,
+                          const char* cpumask,
+                          size_t mask_size) {
+  DWORD_PTR affinity;
+  int err;
+
+  err = uv__cpumask_to_affinity(cpumask, mask_size, &affinity);
+  if (err)
+    return err;
+
+  if (SetThreadAffinityMask(*tid, affinity) == 0)
+    return uv_translate_sys_error(GetLastError());
+
+  return 0;
+}
+
+
 int uv_thread_create(uv_thread_t *tid, void (*entry)(void *arg), void *arg) {
+  return uv_thread_create_ex(tid, NULL, entry, arg);
+}
+
+
+int uv_thread_create_ex(uv_thread_t* tid,
+                        const uv_thread_options_t* params,
+                        void (*entry)(void *arg),
+                        void* arg) {
   struct thread_ctx* ctx;
   int err;
   HANDLE thread;
+  DWORD_PTR affinity;
+  unsigned int stack_size;
+
+  stack_size = 0;
+  affinity = 0;
+  if (params != NULL) {
+    if (params->flags & UV_THREAD_HAS_STACK_SIZE)
+      stack_size = (unsigned int) params->stack_size;
+    if (params->flags & UV_THREAD_HAS_AFFINITY) {
+      err = uv__cpumask_to_affinity(params->cpumask,
+                                    params->mask_size,
+                                    &affinity);
+      if (err)
+        return err;
+    }
+    /* UV_THREAD_HAS_NAME is accepted but ignored, there is no thread name
+     * API on the Windows versions that we support.
+     */
+  }
 
   ctx = uv__malloc(sizeof(*ctx));
   if (ctx == NULL)
@@ -160,7 +233,7 @@ int uv_thread_create(uv_thread_t *tid, void (*entry)(void *arg), void *arg) {
   /* Create the thread in suspended state so we have a chance to pass
    * its own creation handle to it */   
   thread = (HANDLE) _beginthreadex(NULL,
-                                   0,
+                                   stack_size,
                                    uv__thread_start,
                                    ctx,
                                    CREATE_SUSPENDED,
@@ -172,6 +245,8 @@ int uv_thread_create(uv_thread_t *tid, void (*entry)(void *arg), void *arg) {
     err = 0;
     *tid = thread;
     ctx->self = thread;
+    if (affinity != 0)
+      SetThreadAffinityMask(thread, affinity);
     ResumeThread(thread);
   }
 
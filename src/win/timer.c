@@ -68,6 +68,7 @@ int uv_timer_init(uv_loop_t* loop, uv_timer_t* handle) {
   uv__handle_init(loop, (uv_handle_t*) handle, UV_TIMER);
   handle->timer_cb = NULL;
   handle->repeat = 0;
+  handle->slack = 0;
 
   return 0;
 }
@@ -104,7 +105,8 @@ int uv_timer_start(uv_timer_t* handle, uv_timer_cb timer_cb, uint64_t timeout,
     uv_timer_stop(handle);
 
   handle->timer_cb = timer_cb;
-  handle->due = get_clamped_due_time(loop->time, timeout);
+  handle->due = uv__timer_slack_due(get_clamped_due_time(loop->time, timeout),
+                                    handle->slack);
   handle->repeat = repeat;
   uv__handle_start(handle);
 
@@ -118,6 +120,14 @@ int uv_timer_start(uv_timer_t* handle, uv_timer_cb timer_cb, uint64_t timeout,
 }
 
 
+int uv_timer_start_ns(uv_timer_t* handle,
+                      uv_timer_cb timer_cb,
+                      uint64_t timeout,
+                      uint64_t repeat) {
+  return UV_ENOSYS;
+}
+
+
 int uv_timer_stop(uv_timer_t* handle) {
   uv_loop_t* loop = handle->loop;
 
@@ -158,6 +168,18 @@ uint64_t uv_timer_get_repeat(const uv_timer_t* handle) {
 }
 
 
+void uv_timer_set_slack(uv_timer_t* handle, uint64_t slack) {
+  assert(handle->type == UV_TIMER);
+  handle->slack = slack;
+}
+
+
+uint64_t uv_timer_get_slack(const uv_timer_t* handle) {
+  assert(handle->type == UV_TIMER);
+  return handle->slack;
+}
+
+
 DWORD uv__next_timeout(const uv_loop_t* loop) {
   uv_timer_t* timer;
   int64_t delta;
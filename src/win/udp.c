@@ -839,6 +839,9 @@ int uv__udp_bind(uv_udp_t* handle,
                  unsigned int flags) {
   int err;
 
+  if (flags & UV_UDP_REUSEPORT)
+    return UV_ENOTSUP;
+
   err = uv_udp_maybe_bind(handle, addr, addrlen, flags);
   if (err)
     return uv_translate_sys_error(err);
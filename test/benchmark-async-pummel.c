@@ -26,10 +26,13 @@
 #include <stdlib.h>
 
 #define NUM_PINGS               (1000 * 1000)
+#define NUM_IDLE                (20 * 1000)
 #define ACCESS_ONCE(type, var)  (*(volatile type*) &(var))
 
 static unsigned int callbacks;
 static volatile int done;
+static uv_async_t* idle_handles;
+static int nidle;
 
 static const char running[] = "running";
 static const char stop[]    = "stop";
@@ -37,6 +40,8 @@ static const char stopped[] = "stopped";
 
 
 static void async_cb(uv_async_t* handle) {
+  int i;
+
   if (++callbacks == NUM_PINGS) {
     /* Tell the pummel thread to stop. */
     ACCESS_ONCE(const char*, handle->data) = stop;
@@ -46,6 +51,9 @@ static void async_cb(uv_async_t* handle) {
       uv_sleep(0);
 
     uv_close((uv_handle_t*) handle, NULL);
+
+    for (i = 0; i < nidle; i++)
+      uv_close((uv_handle_t*) (idle_handles + i), NULL);
   }
 }
 
@@ -61,7 +69,10 @@ static void pummel(void* arg) {
 }
 
 
-static int test_async_pummel(int nthreads) {
+/* The idle handles are never signaled.  They show the cost of finding the
+ * signaled handle among all the async handles of the loop.
+ */
+static int test_async_pummel(int nthreads, int nidle_handles) {
   uv_thread_t* tids;
   uv_async_t handle;
   uint64_t time;
@@ -70,6 +81,13 @@ static int test_async_pummel(int nthreads) {
   tids = calloc(nthreads, sizeof(tids[0]));
   ASSERT(tids != NULL);
 
+  nidle = nidle_handles;
+  idle_handles = calloc(nidle + 1, sizeof(idle_handles[0]));
+  ASSERT(idle_handles != NULL);
+
+  for (i = 0; i < nidle; i++)
+    ASSERT(0 == uv_async_init(uv_default_loop(), idle_handles + i, async_cb));
+
   ASSERT(0 == uv_async_init(uv_default_loop(), &handle, async_cb));
   ACCESS_ONCE(const char*, handle.data) = running;
 
@@ -86,12 +104,14 @@ static int test_async_pummel(int nthreads) {
   for (i = 0; i < nthreads; i++)
     ASSERT(0 == uv_thread_join(tids + i));
 
-  printf("async_pummel_%d: %s callbacks in %.2f seconds (%s/sec)\n",
+  printf("async_pummel_%d%s: %s callbacks in %.2f seconds (%s/sec)\n",
          nthreads,
+         nidle ? "_idle" : "",
          fmt(callbacks),
          time / 1e9,
          fmt(callbacks / (time / 1e9)));
 
+  free(idle_handles);
   free(tids);
 
   MAKE_VALGRIND_HAPPY();
@@ -100,20 +120,115 @@ static int test_async_pummel(int nthreads) {
 
 
 BENCHMARK_IMPL(async_pummel_1) {
-  return test_async_pummel(1);
+  return test_async_pummel(1, 0);
 }
 
 
 BENCHMARK_IMPL(async_pummel_2) {
-  return test_async_pummel(2);
+  return test_async_pummel(2, 0);
 }
 
 
 BENCHMARK_IMPL(async_pummel_4) {
-  return test_async_pummel(4);
+  return test_async_pummel(4, 0);
 }
 
 
 BENCHMARK_IMPL(async_pummel_8) {
-  return test_async_pummel(8);
+  return test_async_pummel(8, 0);
+}
+
+
+/* Every thread pummels a handle of its own, so the per-handle pending flag
+ * doesn't coalesce anything.  That's left to the loop.
+ */
+static uv_async_t* fanin_handles;
+static uv_thread_t* fanin_tids;
+static uv_timer_t fanin_timer;
+static int fanin_nthreads;
+
+
+static void fanin_cb(uv_async_t* handle) {
+  callbacks++;
+}
+
+
+static void fanin_timer_cb(uv_timer_t* handle) {
+  int i;
+
+  done = 1;
+  for (i = 0; i < fanin_nthreads; i++)
+    ASSERT(0 == uv_thread_join(fanin_tids + i));
+
+  for (i = 0; i < fanin_nthreads; i++)
+    uv_close((uv_handle_t*) (fanin_handles + i), NULL);
+
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+static void fanin(void* arg) {
+  uv_async_t* handle = (uv_async_t*) arg;
+
+  while (ACCESS_ONCE(int, done) == 0)
+    uv_async_send(handle);
+}
+
+
+static int test_async_fanin(int nthreads) {
+  uint64_t time;
+  int i;
+
+  fanin_nthreads = nthreads;
+  fanin_tids = calloc(nthreads, sizeof(fanin_tids[0]));
+  fanin_handles = calloc(nthreads, sizeof(fanin_handles[0]));
+  ASSERT(fanin_tids != NULL);
+  ASSERT(fanin_handles != NULL);
+
+  for (i = 0; i < nthreads; i++)
+    ASSERT(0 == uv_async_init(uv_default_loop(), fanin_handles + i, fanin_cb));
+
+  ASSERT(0 == uv_timer_init(uv_default_loop(), &fanin_timer));
+  ASSERT(0 == uv_timer_start(&fanin_timer, fanin_timer_cb, 5000, 0));
+
+  for (i = 0; i < nthreads; i++)
+    ASSERT(0 == uv_thread_create(fanin_tids + i, fanin, fanin_handles + i));
+
+  time = uv_hrtime();
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  time = uv_hrtime() - time;
+
+  printf("async_fanin_%d: %s callbacks in %.2f seconds (%s/sec)\n",
+         nthreads,
+         fmt(callbacks),
+         time / 1e9,
+         fmt(callbacks / (time / 1e9)));
+
+  free(fanin_handles);
+  free(fanin_tids);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(async_pummel_1_idle) {
+  return test_async_pummel(1, NUM_IDLE);
+}
+
+
+BENCHMARK_IMPL(async_pummel_4_idle) {
+  return test_async_pummel(4, NUM_IDLE);
+}
+
+
+BENCHMARK_IMPL(async_fanin_8) {
+  return test_async_fanin(8);
+}
+
+
+BENCHMARK_IMPL(async_fanin_32) {
+  return test_async_fanin(32);
 }
@@ -0,0 +1,175 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "task.h"
+#include "uv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_MESSAGES  (2 * 1000 * 1000)
+#define CAPACITY      4096
+
+/* Compares uv_channel_t against what programs do without it: a mutex
+ * protected queue of malloc'd messages with an uv_async_t to wake the loop.
+ */
+
+struct message {
+  struct message* next;
+  void* arg;
+};
+
+static uv_channel_t channel;
+static uv_async_t async_handle;
+static uv_mutex_t mutex;
+static struct message* queue_head;
+static struct message** queue_tail;
+static unsigned int callbacks;
+static int nproducers;
+
+
+static void channel_cb(uv_channel_t* handle, void* arg) {
+  if (++callbacks == NUM_MESSAGES)
+    uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+static void channel_producer(void* arg) {
+  int i;
+
+  for (i = 0; i < NUM_MESSAGES / nproducers; i++)
+    while (uv_channel_send(&channel, channel_cb, arg) == UV_EAGAIN)
+      uv_sleep(0);
+}
+
+
+static void async_cb(uv_async_t* handle) {
+  struct message* msg;
+  struct message* next;
+
+  uv_mutex_lock(&mutex);
+  msg = queue_head;
+  queue_head = NULL;
+  queue_tail = &queue_head;
+  uv_mutex_unlock(&mutex);
+
+  for (; msg != NULL; msg = next) {
+    next = msg->next;
+    free(msg);
+
+    if (++callbacks == NUM_MESSAGES)
+      uv_close((uv_handle_t*) handle, NULL);
+  }
+}
+
+
+static void async_producer(void* arg) {
+  struct message* msg;
+  int i;
+
+  for (i = 0; i < NUM_MESSAGES / nproducers; i++) {
+    msg = malloc(sizeof(*msg));
+    ASSERT(msg != NULL);
+    msg->next = NULL;
+    msg->arg = arg;
+
+    uv_mutex_lock(&mutex);
+    *queue_tail = msg;
+    queue_tail = &msg->next;
+    uv_mutex_unlock(&mutex);
+
+    ASSERT(0 == uv_async_send(&async_handle));
+  }
+}
+
+
+static int test_channel(int nthreads, int use_channel) {
+  uv_thread_t* tids;
+  uint64_t time;
+  int i;
+
+  ASSERT(NUM_MESSAGES % nthreads == 0);
+  nproducers = nthreads;
+  callbacks = 0;
+
+  tids = calloc(nthreads, sizeof(tids[0]));
+  ASSERT(tids != NULL);
+
+  if (use_channel) {
+    ASSERT(0 == uv_channel_init(uv_default_loop(), &channel, CAPACITY));
+  } else {
+    queue_head = NULL;
+    queue_tail = &queue_head;
+    ASSERT(0 == uv_mutex_init(&mutex));
+    ASSERT(0 == uv_async_init(uv_default_loop(), &async_handle, async_cb));
+  }
+
+  time = uv_hrtime();
+
+  for (i = 0; i < nthreads; i++)
+    ASSERT(0 == uv_thread_create(tids + i,
+                                 use_channel ? channel_producer
+                                             : async_producer,
+                                 NULL));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  time = uv_hrtime() - time;
+
+  for (i = 0; i < nthreads; i++)
+    ASSERT(0 == uv_thread_join(tids + i));
+
+  if (!use_channel)
+    uv_mutex_destroy(&mutex);
+
+  printf("%s_%d: %s messages in %.2f seconds (%s/sec)\n",
+         use_channel ? "channel_pummel" : "channel_async_queue",
+         nthreads,
+         fmt(callbacks),
+         time / 1e9,
+         fmt(callbacks / (time / 1e9)));
+
+  free(tids);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(channel_pummel_1) {
+  return test_channel(1, 1);
+}
+
+
+BENCHMARK_IMPL(channel_pummel_4) {
+  return test_channel(4, 1);
+}
+
+
+BENCHMARK_IMPL(channel_async_queue_1) {
+  return test_channel(1, 0);
+}
+
+
+BENCHMARK_IMPL(channel_async_queue_4) {
+  return test_channel(4, 0);
+}
@@ -21,8 +21,11 @@
 
 BENCHMARK_DECLARE (sizes)
 BENCHMARK_DECLARE (loop_count)
+BENCHMARK_DECLARE (loop_count_precise_clock)
+BENCHMARK_DECLARE (loop_count_fast_clock)
 BENCHMARK_DECLARE (loop_count_timed)
 BENCHMARK_DECLARE (ping_pongs)
+BENCHMARK_DECLARE (ping_pongs_busy_poll)
 BENCHMARK_DECLARE (tcp_write_batch)
 BENCHMARK_DECLARE (tcp4_pound_100)
 BENCHMARK_DECLARE (tcp4_pound_1000)
@@ -36,6 +39,9 @@ BENCHMARK_DECLARE (pipe_pump1_client)
 BENCHMARK_DECLARE (tcp_multi_accept2)
 BENCHMARK_DECLARE (tcp_multi_accept4)
 BENCHMARK_DECLARE (tcp_multi_accept8)
+BENCHMARK_DECLARE (tcp_multi_accept2_reuseport)
+BENCHMARK_DECLARE (tcp_multi_accept4_reuseport)
+BENCHMARK_DECLARE (tcp_multi_accept8_reuseport)
 
 /* Run until X packets have been sent/received. */
 BENCHMARK_DECLARE (udp_pummel_1v1)
@@ -71,10 +77,25 @@ BENCHMARK_DECLARE (async_pummel_1)
 BENCHMARK_DECLARE (async_pummel_2)
 BENCHMARK_DECLARE (async_pummel_4)
 BENCHMARK_DECLARE (async_pummel_8)
+BENCHMARK_DECLARE (async_pummel_1_idle)
+BENCHMARK_DECLARE (async_pummel_4_idle)
+BENCHMARK_DECLARE (async_fanin_8)
+BENCHMARK_DECLARE (async_fanin_32)
+BENCHMARK_DECLARE (channel_pummel_1)
+BENCHMARK_DECLARE (channel_pummel_4)
+BENCHMARK_DECLARE (channel_async_queue_1)
+BENCHMARK_DECLARE (channel_async_queue_4)
 BENCHMARK_DECLARE (spawn)
 BENCHMARK_DECLARE (thread_create)
+BENCHMARK_DECLARE (threadpool_contention_1)
+BENCHMARK_DECLARE (threadpool_contention_4)
+BENCHMARK_DECLARE (threadpool_fanout)
+BENCHMARK_DECLARE (threadpool_fanout_many)
 BENCHMARK_DECLARE (million_async)
 BENCHMARK_DECLARE (million_timers)
+BENCHMARK_DECLARE (million_timers_wheel)
+BENCHMARK_DECLARE (timer_restart_churn)
+BENCHMARK_DECLARE (timer_restart_churn_wheel)
 HELPER_DECLARE    (tcp4_blackhole_server)
 HELPER_DECLARE    (tcp_pump_server)
 HELPER_DECLARE    (pipe_pump_server)
@@ -85,11 +106,16 @@ HELPER_DECLARE    (dns_server)
 TASK_LIST_START
   BENCHMARK_ENTRY  (sizes)
   BENCHMARK_ENTRY  (loop_count)
+  BENCHMARK_ENTRY  (loop_count_precise_clock)
+  BENCHMARK_ENTRY  (loop_count_fast_clock)
   BENCHMARK_ENTRY  (loop_count_timed)
 
   BENCHMARK_ENTRY  (ping_pongs)
   BENCHMARK_HELPER (ping_pongs, tcp4_echo_server)
 
+  BENCHMARK_ENTRY  (ping_pongs_busy_poll)
+  BENCHMARK_HELPER (ping_pongs_busy_poll, tcp4_echo_server)
+
   BENCHMARK_ENTRY  (tcp_write_batch)
   BENCHMARK_HELPER (tcp_write_batch, tcp4_blackhole_server)
 
@@ -120,6 +146,9 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (tcp_multi_accept2)
   BENCHMARK_ENTRY  (tcp_multi_accept4)
   BENCHMARK_ENTRY  (tcp_multi_accept8)
+  BENCHMARK_ENTRY  (tcp_multi_accept2_reuseport)
+  BENCHMARK_ENTRY  (tcp_multi_accept4_reuseport)
+  BENCHMARK_ENTRY  (tcp_multi_accept8_reuseport)
 
   BENCHMARK_ENTRY  (udp_pummel_1v1)
   BENCHMARK_ENTRY  (udp_pummel_1v10)
@@ -155,9 +184,24 @@ TASK_LIST_START
   BENCHMARK_ENTRY  (async_pummel_2)
   BENCHMARK_ENTRY  (async_pummel_4)
   BENCHMARK_ENTRY  (async_pummel_8)
+  BENCHMARK_ENTRY  (async_pummel_1_idle)
+  BENCHMARK_ENTRY  (async_pummel_4_idle)
+  BENCHMARK_ENTRY  (async_fanin_8)
+  BENCHMARK_ENTRY  (async_fanin_32)
+  BENCHMARK_ENTRY  (channel_pummel_1)
+  BENCHMARK_ENTRY  (channel_pummel_4)
+  BENCHMARK_ENTRY  (channel_async_queue_1)
+  BENCHMARK_ENTRY  (channel_async_queue_4)
 
   BENCHMARK_ENTRY  (spawn)
   BENCHMARK_ENTRY  (thread_create)
+  BENCHMARK_ENTRY  (threadpool_contention_1)
+  BENCHMARK_ENTRY  (threadpool_contention_4)
+  BENCHMARK_ENTRY  (threadpool_fanout)
+  BENCHMARK_ENTRY  (threadpool_fanout_many)
   BENCHMARK_ENTRY  (million_async)
   BENCHMARK_ENTRY  (million_timers)
+  BENCHMARK_ENTRY  (million_timers_wheel)
+  BENCHMARK_ENTRY  (timer_restart_churn)
+  BENCHMARK_ENTRY  (timer_restart_churn_wheel)
 TASK_LIST_END
@@ -49,10 +49,13 @@ static void timer_cb(uv_timer_t* handle) {
 }
 
 
-BENCHMARK_IMPL(loop_count) {
+static int loop_count(const char* name, int mode) {
   uv_loop_t* loop = uv_default_loop();
   uint64_t ns;
 
+  if (mode != UV_CLOCK_MODE_DEFAULT)
+    ASSERT(0 == uv_loop_configure(loop, UV_LOOP_CLOCK_MODE, mode));
+
   uv_idle_init(loop, &idle_handle);
   uv_idle_start(&idle_handle, idle_cb);
 
@@ -62,7 +65,8 @@ BENCHMARK_IMPL(loop_count) {
 
   ASSERT(ticks == NUM_TICKS);
 
-  fprintf(stderr, "loop_count: %d ticks in %.2fs (%.0f/s)\n",
+  fprintf(stderr, "%s: %d ticks in %.2fs (%.0f/s)\n",
+          name,
           NUM_TICKS,
           ns / 1e9,
           NUM_TICKS / (ns / 1e9));
@@ -73,6 +77,21 @@ BENCHMARK_IMPL(loop_count) {
 }
 
 
+BENCHMARK_IMPL(loop_count) {
+  return loop_count("loop_count", UV_CLOCK_MODE_DEFAULT);
+}
+
+
+BENCHMARK_IMPL(loop_count_precise_clock) {
+  return loop_count("loop_count_precise_clock", UV_CLOCK_MODE_PRECISE);
+}
+
+
+BENCHMARK_IMPL(loop_count_fast_clock) {
+  return loop_count("loop_count_fast_clock", UV_CLOCK_MODE_FAST);
+}
+
+
 BENCHMARK_IMPL(loop_count_timed) {
   uv_loop_t* loop = uv_default_loop();
 
@@ -70,6 +70,7 @@ struct server_ctx {
   uv_async_t async_handle;
   uv_thread_t thread_id;
   uv_sem_t semaphore;
+  int reuseport;
 };
 
 struct client_ctx {
@@ -260,15 +261,23 @@ static void server_cb(void *arg) {
   ASSERT(0 == uv_async_init(&loop, &ctx->async_handle, sv_async_cb));
   uv_unref((uv_handle_t*) &ctx->async_handle);
 
-  /* Wait until the main thread is ready. */
-  uv_sem_wait(&ctx->semaphore);
-  get_listen_handle(&loop, (uv_stream_t*) &ctx->server_handle);
-  uv_sem_post(&ctx->semaphore);
+  if (ctx->reuseport) {
+    /* Every thread has a listen socket of its own, the kernel balances. */
+    ASSERT(0 == uv_tcp_init(&loop, (uv_tcp_t*) &ctx->server_handle));
+    ASSERT(0 == uv_tcp_bind((uv_tcp_t*) &ctx->server_handle,
+                            (const struct sockaddr*) &listen_addr,
+                            UV_TCP_REUSEPORT));
+  } else {
+    /* Wait until the main thread is ready. */
+    uv_sem_wait(&ctx->semaphore);
+    get_listen_handle(&loop, (uv_stream_t*) &ctx->server_handle);
+  }
 
   /* Now start the actual benchmark. */
   ASSERT(0 == uv_listen((uv_stream_t*) &ctx->server_handle,
                         128,
                         sv_connection_cb));
+  uv_sem_post(&ctx->semaphore);
   ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
 
   uv_loop_close(&loop);
@@ -355,7 +364,9 @@ static void cl_close_cb(uv_handle_t* handle) {
 }
 
 
-static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
+static int test_tcp(unsigned int num_servers,
+                    unsigned int num_clients,
+                    int reuseport) {
   struct server_ctx* servers;
   struct client_ctx* clients;
   uv_loop_t* loop;
@@ -377,11 +388,17 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
    */
   for (i = 0; i < num_servers; i++) {
     struct server_ctx* ctx = servers + i;
+    ctx->reuseport = reuseport;
     ASSERT(0 == uv_sem_init(&ctx->semaphore, 0));
     ASSERT(0 == uv_thread_create(&ctx->thread_id, server_cb, ctx));
   }
 
-  send_listen_handles(UV_TCP, num_servers, servers);
+  if (reuseport) {
+    for (i = 0; i < num_servers; i++)
+      uv_sem_wait(&servers[i].semaphore);
+  } else {
+    send_listen_handles(UV_TCP, num_servers, servers);
+  }
 
   for (i = 0; i < num_clients; i++) {
     struct client_ctx* ctx = clients + i;
@@ -410,8 +427,9 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
     uv_sem_destroy(&ctx->semaphore);
   }
 
-  printf("accept%u: %.0f accepts/sec (%u total)\n",
+  printf("accept%u%s: %.0f accepts/sec (%u total)\n",
          num_servers,
+         reuseport ? " (SO_REUSEPORT)" : "",
          NUM_CONNECTS / time,
          NUM_CONNECTS);
 
@@ -433,15 +451,30 @@ static int test_tcp(unsigned int num_servers, unsigned int num_clients) {
 
 
 BENCHMARK_IMPL(tcp_multi_accept2) {
-  return test_tcp(2, 40);
+  return test_tcp(2, 40, 0);
 }
 
 
 BENCHMARK_IMPL(tcp_multi_accept4) {
-  return test_tcp(4, 40);
+  return test_tcp(4, 40, 0);
 }
 
 
 BENCHMARK_IMPL(tcp_multi_accept8) {
-  return test_tcp(8, 40);
+  return test_tcp(8, 40, 0);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept2_reuseport) {
+  return test_tcp(2, 40, 1);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept4_reuseport) {
+  return test_tcp(4, 40, 1);
+}
+
+
+BENCHMARK_IMPL(tcp_multi_accept8_reuseport) {
+  return test_tcp(8, 40, 1);
 }
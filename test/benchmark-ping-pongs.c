@@ -77,10 +77,20 @@ static void buf_free(const uv_buf_t* buf) {
 
 
 static void pinger_close_cb(uv_handle_t* handle) {
+  uv_metrics_t metrics;
   pinger_t* pinger;
 
   pinger = (pinger_t*)handle->data;
   fprintf(stderr, "ping_pongs: %d roundtrips/s\n", (1000 * pinger->pongs) / TIME);
+  if (uv_loop_metrics(loop, &metrics) == 0) {
+    fprintf(stderr, "ping_pongs: %llu backend_ctl calls, %llu saved\n",
+            (unsigned long long) metrics.backend_ctl,
+            (unsigned long long) metrics.backend_ctl_saved);
+    if (metrics.busy_poll_hits + metrics.busy_poll_misses != 0)
+      fprintf(stderr, "ping_pongs: busy poll %llu hits, %llu misses\n",
+              (unsigned long long) metrics.busy_poll_hits,
+              (unsigned long long) metrics.busy_poll_misses);
+  }
   fflush(stderr);
 
   free(pinger);
@@ -206,9 +216,12 @@ static void pinger_new(void) {
 }
 
 
-BENCHMARK_IMPL(ping_pongs) {
+static int ping_pongs(int busy_poll) {
   loop = uv_default_loop();
 
+  if (busy_poll != 0)
+    ASSERT(0 == uv_loop_configure(loop, UV_LOOP_BUSY_POLL, busy_poll));
+
   start_time = uv_now(loop);
 
   pinger_new();
@@ -219,3 +232,17 @@ BENCHMARK_IMPL(ping_pongs) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+BENCHMARK_IMPL(ping_pongs) {
+  return ping_pongs(0);
+}
+
+
+BENCHMARK_IMPL(ping_pongs_busy_poll) {
+#if defined(__linux__)
+  return ping_pongs(50);
+#else
+  RETURN_SKIP("Busy polling is only implemented on Linux.");
+#endif
+}
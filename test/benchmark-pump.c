@@ -86,6 +86,7 @@ static double gbit(int64_t bytes, int64_t passed_ms) {
 
 
 static void show_stats(uv_timer_t* handle) {
+  uv_metrics_t metrics;
   int64_t diff;
   int i;
 
@@ -106,6 +107,12 @@ static void show_stats(uv_timer_t* handle) {
             type == TCP ? "tcp" : "pipe",
             write_sockets,
             gbit(nsent_total, diff));
+    if (uv_loop_metrics(loop, &metrics) == 0)
+      fprintf(stderr, "%s_pump%d_client: %llu backend_ctl calls, %llu saved\n",
+              type == TCP ? "tcp" : "pipe",
+              write_sockets,
+              (unsigned long long) metrics.backend_ctl,
+              (unsigned long long) metrics.backend_ctl_saved);
     fflush(stderr);
 
     for (i = 0; i < write_sockets; i++) {
@@ -125,6 +132,7 @@ static void show_stats(uv_timer_t* handle) {
 
 
 static void read_show_stats(void) {
+  uv_metrics_t metrics;
   int64_t diff;
 
   uv_update_time(loop);
@@ -134,6 +142,12 @@ static void read_show_stats(void) {
           type == TCP ? "tcp" : "pipe",
           max_read_sockets,
           gbit(nrecv_total, diff));
+  if (uv_loop_metrics(loop, &metrics) == 0)
+    fprintf(stderr, "%s_pump%d_server: %llu backend_ctl calls, %llu saved\n",
+            type == TCP ? "tcp" : "pipe",
+            max_read_sockets,
+            (unsigned long long) metrics.backend_ctl,
+            (unsigned long long) metrics.backend_ctl_saved);
   fflush(stderr);
 }
 
@@ -0,0 +1,213 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_WORK     (1000 * 1000)
+#define NUM_INFLIGHT 256
+
+/* Loops on threads of their own hammer the pool with empty work items, that
+ * way the benchmark measures the cost of getting work in and out of the pool
+ * rather than the work itself. Set UV_THREADPOOL_SIZE to vary the number of
+ * workers.
+ */
+
+struct submitter {
+  uv_loop_t loop;
+  uv_thread_t thread;
+  uv_work_t reqs[NUM_INFLIGHT];
+  unsigned int submitted;
+  unsigned int completed;
+  unsigned int total;
+};
+
+
+static void work_cb(uv_work_t* req) {
+  /* Nothing. */
+}
+
+
+static void after_work_cb(uv_work_t* req, int status) {
+  struct submitter* s;
+
+  ASSERT(status == 0);
+  s = req->data;
+  s->completed++;
+
+  if (s->submitted < s->total) {
+    s->submitted++;
+    ASSERT(0 == uv_queue_work(&s->loop, req, work_cb, after_work_cb));
+  }
+}
+
+
+static void submitter_run(void* arg) {
+  struct submitter* s;
+  unsigned int i;
+
+  s = arg;
+
+  for (i = 0; i < NUM_INFLIGHT && s->submitted < s->total; i++) {
+    s->reqs[i].data = s;
+    s->submitted++;
+    ASSERT(0 == uv_queue_work(&s->loop, s->reqs + i, work_cb, after_work_cb));
+  }
+
+  ASSERT(0 == uv_run(&s->loop, UV_RUN_DEFAULT));
+  ASSERT(s->completed == s->total);
+}
+
+
+static int threadpool_contention(int nloops) {
+  struct submitter* submitters;
+  uint64_t duration;
+  uv_work_t req;
+  int i;
+
+  submitters = calloc(nloops, sizeof(submitters[0]));
+  ASSERT(submitters != NULL);
+
+  /* Start the pool before the clock does. */
+  ASSERT(0 == uv_queue_work(uv_default_loop(), &req, work_cb, NULL));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+
+  for (i = 0; i < nloops; i++) {
+    ASSERT(0 == uv_loop_init(&submitters[i].loop));
+    submitters[i].total = NUM_WORK / nloops;
+  }
+
+  duration = uv_hrtime();
+
+  for (i = 0; i < nloops; i++)
+    ASSERT(0 == uv_thread_create(&submitters[i].thread,
+                                 submitter_run,
+                                 submitters + i));
+
+  for (i = 0; i < nloops; i++)
+    ASSERT(0 == uv_thread_join(&submitters[i].thread));
+
+  duration = uv_hrtime() - duration;
+
+  for (i = 0; i < nloops; i++)
+    ASSERT(0 == uv_loop_close(&submitters[i].loop));
+
+  printf("threadpool_contention_%d: %s work items in %.2f seconds (%s/s)\n",
+         nloops,
+         fmt(NUM_WORK),
+         duration / 1e9,
+         fmt(NUM_WORK / (duration / 1e9)));
+
+  free(submitters);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(threadpool_contention_1) {
+  return threadpool_contention(1);
+}
+
+
+BENCHMARK_IMPL(threadpool_contention_4) {
+  return threadpool_contention(4);
+}
+
+
+#define NUM_FANOUT 4096
+
+/* The loop submits NUM_FANOUT empty work items at once and waits for all of
+ * them before it starts the next round, like a scan that fans out over many
+ * files. Compares submitting them one by one with uv_queue_work_many().
+ */
+
+static uv_work_t fanout_reqs[NUM_FANOUT];
+static unsigned int fanout_pending;
+
+
+static void fanout_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  fanout_pending--;
+}
+
+
+static int threadpool_fanout(int many) {
+  uint64_t duration;
+  unsigned int rounds;
+  unsigned int i;
+  uv_loop_t* loop;
+  uv_work_t req;
+
+  loop = uv_default_loop();
+
+  /* Start the pool before the clock does. */
+  ASSERT(0 == uv_queue_work(loop, &req, work_cb, NULL));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  duration = uv_hrtime();
+
+  for (rounds = 0; rounds < NUM_WORK / NUM_FANOUT; rounds++) {
+    fanout_pending = NUM_FANOUT;
+
+    if (many)
+      ASSERT(0 == uv_queue_work_many(loop,
+                                     fanout_reqs,
+                                     NUM_FANOUT,
+                                     UV_WORK_CPU,
+                                     work_cb,
+                                     fanout_after_work_cb));
+    else
+      for (i = 0; i < NUM_FANOUT; i++)
+        ASSERT(0 == uv_queue_work(loop,
+                                  fanout_reqs + i,
+                                  work_cb,
+                                  fanout_after_work_cb));
+
+    ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+    ASSERT(fanout_pending == 0);
+  }
+
+  duration = uv_hrtime() - duration;
+
+  printf("threadpool_fanout%s: %s work items in %.2f seconds (%s/s)\n",
+         many ? "_many" : "",
+         fmt(rounds * NUM_FANOUT),
+         duration / 1e9,
+         fmt(rounds * NUM_FANOUT / (duration / 1e9)));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(threadpool_fanout) {
+  return threadpool_fanout(0);
+}
+
+
+BENCHMARK_IMPL(threadpool_fanout_many) {
+  return threadpool_fanout(1);
+}
@@ -0,0 +1,101 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "task.h"
+#include "uv.h"
+
+/* Models idle timeouts on a busy server: every "read" on a connection pushes
+ * its timer back.  The timers never expire, all the work is in restarting.
+ */
+#define NUM_TIMERS (500 * 1000)
+#define NUM_ROUNDS 20
+#define IDLE_TIMEOUT 30000
+
+static int timer_cb_called;
+
+
+static void timer_cb(uv_timer_t* handle) {
+  timer_cb_called++;
+}
+
+
+static int timer_restart_churn(int wheel) {
+  uv_timer_t* timers;
+  uv_loop_t* loop;
+  uint64_t before;
+  uint64_t after;
+  unsigned int seed;
+  int round;
+  int i;
+
+  timers = malloc(NUM_TIMERS * sizeof(timers[0]));
+  ASSERT(timers != NULL);
+
+  loop = uv_default_loop();
+  if (wheel)
+    ASSERT(0 == uv_loop_configure(loop, UV_LOOP_TIMER_WHEEL));
+
+  seed = 1;
+  for (i = 0; i < NUM_TIMERS; i++) {
+    ASSERT(0 == uv_timer_init(loop, timers + i));
+    ASSERT(0 == uv_timer_start(timers + i, timer_cb, IDLE_TIMEOUT, 0));
+  }
+
+  before = uv_hrtime();
+  for (round = 0; round < NUM_ROUNDS; round++) {
+    uv_update_time(loop);
+    /* Connections see traffic in no particular order. */
+    for (i = 0; i < NUM_TIMERS; i++) {
+      seed = seed * 1103515245 + 12345;
+      ASSERT(0 == uv_timer_start(timers + (seed >> 4) % NUM_TIMERS,
+                                 timer_cb,
+                                 IDLE_TIMEOUT + (seed >> 16) % 1000,
+                                 0));
+    }
+  }
+  after = uv_hrtime();
+
+  for (i = 0; i < NUM_TIMERS; i++)
+    uv_close((uv_handle_t*) (timers + i), NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(timer_cb_called == 0);
+  free(timers);
+
+  fprintf(stderr,
+          "timer_restart_churn%s: %.0f restarts/s\n",
+          wheel ? "_wheel" : "",
+          (double) NUM_TIMERS * NUM_ROUNDS / ((after - before) / 1e9));
+  fflush(stderr);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+BENCHMARK_IMPL(timer_restart_churn) {
+  return timer_restart_churn(0);
+}
+
+
+BENCHMARK_IMPL(timer_restart_churn_wheel) {
+  return timer_restart_churn(1);
+}
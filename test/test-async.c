@@ -132,3 +132,123 @@ TEST_IMPL(async) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+static uv_async_t pending_handles[4];
+static int pending_cb_called[4];
+
+
+static void pending_cb(uv_async_t* handle) {
+  int i;
+
+  i = handle - pending_handles;
+  pending_cb_called[i]++;
+
+  /* Handles run in the order in which they were signaled. */
+  if (i == 0)
+    ASSERT(pending_cb_called[3] == 0);
+
+  /* Close a handle that is waiting further down in the same batch. */
+  if (i == 3 && pending_cb_called[3] == 1)
+    uv_close((uv_handle_t*) (pending_handles + 2), NULL);
+}
+
+
+TEST_IMPL(async_close_pending) {
+  int i;
+
+  for (i = 0; i < 4; i++)
+    ASSERT(0 == uv_async_init(uv_default_loop(),
+                              pending_handles + i,
+                              pending_cb));
+
+  ASSERT(0 == uv_async_send(pending_handles + 0));
+  ASSERT(0 == uv_async_send(pending_handles + 1));
+  ASSERT(0 == uv_async_send(pending_handles + 3));
+  ASSERT(0 == uv_async_send(pending_handles + 2));
+  ASSERT(0 == uv_async_send(pending_handles + 0));
+
+  /* Signaled but not dispatched yet, must not be seen again. */
+  uv_close((uv_handle_t*) (pending_handles + 1), NULL);
+
+  ASSERT(0 != uv_run(uv_default_loop(), UV_RUN_ONCE));
+
+  ASSERT(pending_cb_called[0] == 1);
+  ASSERT(pending_cb_called[1] == 0);
+  ASSERT(pending_cb_called[2] == 0);
+  ASSERT(pending_cb_called[3] == 1);
+
+  /* Signaling again after the callback ran works as before. */
+  ASSERT(0 == uv_async_send(pending_handles + 3));
+  ASSERT(0 != uv_run(uv_default_loop(), UV_RUN_ONCE));
+  ASSERT(pending_cb_called[3] == 2);
+
+  uv_close((uv_handle_t*) (pending_handles + 0), NULL);
+  uv_close((uv_handle_t*) (pending_handles + 3), NULL);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(pending_cb_called[0] == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#define ROUNDS 200
+#define ROUND_HANDLES 64
+
+static uv_async_t round_handles[ROUND_HANDLES];
+static uv_sem_t round_sem;
+static uv_thread_t round_thread;
+static int round_seen;
+static int rounds_done;
+
+
+static void round_thread_cb(void* arg) {
+  int round;
+  int i;
+
+  /* Only the first send of a round finds the loop idle, the others have to
+   * rely on that one wakeup.
+   */
+  for (round = 0; round < ROUNDS; round++) {
+    for (i = 0; i < ROUND_HANDLES; i++)
+      ASSERT(0 == uv_async_send(round_handles + i));
+    uv_sem_wait(&round_sem);
+  }
+}
+
+
+static void round_cb(uv_async_t* handle) {
+  int i;
+
+  if (++round_seen < ROUND_HANDLES)
+    return;
+
+  round_seen = 0;
+  uv_sem_post(&round_sem);
+  if (++rounds_done < ROUNDS)
+    return;
+
+  for (i = 0; i < ROUND_HANDLES; i++)
+    uv_close((uv_handle_t*) (round_handles + i), NULL);
+}
+
+
+TEST_IMPL(async_many_handles) {
+  int i;
+
+  ASSERT(0 == uv_sem_init(&round_sem, 0));
+
+  for (i = 0; i < ROUND_HANDLES; i++)
+    ASSERT(0 == uv_async_init(uv_default_loop(), round_handles + i, round_cb));
+
+  ASSERT(0 == uv_thread_create(&round_thread, round_thread_cb, NULL));
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(0 == uv_thread_join(&round_thread));
+  ASSERT(rounds_done == ROUNDS);
+
+  uv_sem_destroy(&round_sem);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -0,0 +1,195 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#define NUM_THREADS 4
+#define NUM_MESSAGES 20000
+
+static uv_channel_t channel;
+static int msg_cb_called;
+static int close_cb_called;
+static int last_value;
+
+
+static void close_cb(uv_handle_t* handle) {
+  ASSERT(handle == (uv_handle_t*) &channel);
+  close_cb_called++;
+}
+
+
+static void order_cb(uv_channel_t* handle, void* arg) {
+  ASSERT(handle == &channel);
+  ASSERT((int) (intptr_t) arg == last_value + 1);
+  last_value++;
+  msg_cb_called++;
+}
+
+
+TEST_IMPL(channel) {
+  uv_channel_t invalid;
+  int i;
+
+#ifdef _WIN32
+  ASSERT(UV_ENOSYS == uv_channel_init(uv_default_loop(), &channel, 8));
+  RETURN_SKIP("uv_channel_t is not implemented on Windows.");
+#endif
+
+  ASSERT(UV_EINVAL == uv_channel_init(uv_default_loop(), &invalid, 0));
+  ASSERT(UV_EINVAL == uv_channel_init(uv_default_loop(), &invalid, 1));
+  ASSERT(UV_EINVAL == uv_channel_init(uv_default_loop(), &invalid, 12));
+
+  ASSERT(0 == uv_channel_init(uv_default_loop(), &channel, 8));
+  ASSERT(UV_EINVAL == uv_channel_send(&channel, NULL, NULL));
+
+  /* Fill the channel, the next message doesn't fit. */
+  for (i = 1; i <= 8; i++)
+    ASSERT(0 == uv_channel_send(&channel, order_cb, (void*) (intptr_t) i));
+  ASSERT(UV_EAGAIN == uv_channel_send(&channel, order_cb, (void*) 9));
+
+  ASSERT(0 != uv_run(uv_default_loop(), UV_RUN_ONCE));
+  ASSERT(msg_cb_called == 8);
+
+  /* Room again, and the ring wraps around. */
+  for (i = 9; i <= 14; i++)
+    ASSERT(0 == uv_channel_send(&channel, order_cb, (void*) (intptr_t) i));
+
+  ASSERT(0 != uv_run(uv_default_loop(), UV_RUN_ONCE));
+  ASSERT(msg_cb_called == 14);
+
+  uv_close((uv_handle_t*) &channel, close_cb);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static uv_thread_t threads[NUM_THREADS];
+static int received[NUM_THREADS];
+
+
+static void thread_msg_cb(uv_channel_t* handle, void* arg) {
+  int* count;
+
+  count = arg;
+  (*count)++;
+
+  if (++msg_cb_called == NUM_THREADS * NUM_MESSAGES)
+    uv_close((uv_handle_t*) handle, close_cb);
+}
+
+
+static void producer(void* arg) {
+  int err;
+  int i;
+
+  for (i = 0; i < NUM_MESSAGES; i++) {
+    /* Full, give the loop a chance to catch up. */
+    while ((err = uv_channel_send(&channel, thread_msg_cb, arg)) == UV_EAGAIN)
+      uv_sleep(1);
+    ASSERT(err == 0);
+  }
+}
+
+
+TEST_IMPL(channel_threads) {
+  int i;
+
+#ifdef _WIN32
+  RETURN_SKIP("uv_channel_t is not implemented on Windows.");
+#endif
+
+  /* Small enough that the producers run into the backpressure. */
+  ASSERT(0 == uv_channel_init(uv_default_loop(), &channel, 64));
+
+  for (i = 0; i < NUM_THREADS; i++)
+    ASSERT(0 == uv_thread_create(threads + i, producer, received + i));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == 1);
+  ASSERT(msg_cb_called == NUM_THREADS * NUM_MESSAGES);
+
+  for (i = 0; i < NUM_THREADS; i++) {
+    ASSERT(0 == uv_thread_join(threads + i));
+    ASSERT(received[i] == NUM_MESSAGES);
+  }
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static void close_in_cb(uv_channel_t* handle, void* arg) {
+  msg_cb_called++;
+  uv_close((uv_handle_t*) handle, close_cb);
+}
+
+
+TEST_IMPL(channel_close_in_cb) {
+#ifdef _WIN32
+  RETURN_SKIP("uv_channel_t is not implemented on Windows.");
+#endif
+
+  ASSERT(0 == uv_channel_init(uv_default_loop(), &channel, 4));
+  ASSERT(0 == uv_channel_send(&channel, close_in_cb, NULL));
+  ASSERT(0 == uv_channel_send(&channel, close_in_cb, NULL));
+  ASSERT(0 == uv_channel_send(&channel, close_in_cb, NULL));
+
+  /* The messages that are left are dropped. */
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(msg_cb_called == 1);
+  ASSERT(close_cb_called == 1);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(channel_min_capacity) {
+  int i;
+
+#ifdef _WIN32
+  RETURN_SKIP("uv_channel_t is not implemented on Windows.");
+#endif
+
+  ASSERT(0 == uv_channel_init(uv_default_loop(), &channel, 2));
+
+  /* Go around the ring a few times, each lap fills it up. */
+  for (i = 1; i <= 8; i += 2) {
+    ASSERT(0 == uv_channel_send(&channel, order_cb, (void*) (intptr_t) i));
+    ASSERT(0 == uv_channel_send(&channel, order_cb, (void*) (intptr_t) (i + 1)));
+    ASSERT(UV_EAGAIN == uv_channel_send(&channel, order_cb, NULL));
+
+    ASSERT(0 != uv_run(uv_default_loop(), UV_RUN_ONCE));
+    ASSERT(msg_cb_called == i + 1);
+  }
+
+  uv_close((uv_handle_t*) &channel, close_cb);
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == 1);
+  ASSERT(last_value == 8);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -2328,3 +2328,96 @@ TEST_IMPL(fs_write_multiple_bufs) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+#define NUM_SERIAL_WRITES 64
+
+static uv_fs_t serial_write_reqs[NUM_SERIAL_WRITES];
+static int serial_writes_done;
+
+
+static void serial_write_cb(uv_fs_t* req) {
+  ASSERT(req == serial_write_reqs + serial_writes_done);
+  ASSERT(req->result == 1);
+  uv_fs_req_cleanup(req);
+  serial_writes_done++;
+}
+
+
+static void serial_close_cb(uv_fs_t* req) {
+  ASSERT(req == &close_req);
+  ASSERT(req->result == 0);
+  /* Queued after the writes, so it runs after them. */
+  ASSERT(serial_writes_done == NUM_SERIAL_WRITES);
+  uv_fs_req_cleanup(req);
+  close_cb_count++;
+}
+
+
+TEST_IMPL(fs_write_serial) {
+  static char data[NUM_SERIAL_WRITES];
+  char buf[NUM_SERIAL_WRITES + 1];
+  uv_serial_t serial;
+  uv_buf_t iov;
+  uv_file file;
+  int r;
+  int i;
+
+  /* Setup. */
+  unlink("test_file");
+
+  loop = uv_default_loop();
+
+  r = uv_fs_open(loop, &open_req1, "test_file", O_WRONLY | O_CREAT,
+      S_IWUSR | S_IRUSR, NULL);
+  ASSERT(r >= 0);
+  file = open_req1.result;
+  uv_fs_req_cleanup(&open_req1);
+
+  /* Without the serial queue the one byte writes could land in any order. */
+  ASSERT(0 == uv_serial_init(loop, &serial));
+
+  iov = uv_buf_init(data, 1);
+  r = uv_serial_fs_write(&serial, serial_write_reqs, file, &iov, 1, -1, NULL);
+  ASSERT(r == UV_EINVAL);
+
+  for (i = 0; i < NUM_SERIAL_WRITES; i++) {
+    data[i] = 'A' + i % 26;
+    iov = uv_buf_init(data + i, 1);
+    r = uv_serial_fs_write(&serial, serial_write_reqs + i, file, &iov, 1, -1,
+        serial_write_cb);
+    ASSERT(r == 0);
+  }
+
+  r = uv_serial_fs_close(&serial, &close_req, file, serial_close_cb);
+  ASSERT(r == 0);
+
+  ASSERT(UV_EBUSY == uv_serial_destroy(&serial));
+
+  uv_run(loop, UV_RUN_DEFAULT);
+  ASSERT(serial_writes_done == NUM_SERIAL_WRITES);
+  ASSERT(close_cb_count == 1);
+  ASSERT(0 == uv_serial_destroy(&serial));
+
+  r = uv_fs_open(loop, &open_req1, "test_file", O_RDONLY, 0, NULL);
+  ASSERT(r >= 0);
+  file = open_req1.result;
+  uv_fs_req_cleanup(&open_req1);
+
+  memset(buf, 0, sizeof(buf));
+  iov = uv_buf_init(buf, sizeof(buf));
+  r = uv_fs_read(loop, &read_req, file, &iov, 1, 0, NULL);
+  ASSERT(r == NUM_SERIAL_WRITES);
+  ASSERT(memcmp(buf, data, NUM_SERIAL_WRITES) == 0);
+  uv_fs_req_cleanup(&read_req);
+
+  r = uv_fs_close(loop, &close_req, file, NULL);
+  ASSERT(r == 0);
+  uv_fs_req_cleanup(&close_req);
+
+  /* Cleanup */
+  unlink("test_file");
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
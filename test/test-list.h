@@ -29,7 +29,21 @@ TEST_DECLARE   (loop_close)
 TEST_DECLARE   (loop_stop)
 TEST_DECLARE   (loop_update_time)
 TEST_DECLARE   (loop_backend_timeout)
+TEST_DECLARE   (loop_clock_mode)
 TEST_DECLARE   (loop_configure)
+TEST_DECLARE   (loop_edge_triggered_tcp)
+TEST_DECLARE   (loop_edge_triggered_udp)
+TEST_DECLARE   (loop_edge_triggered_ctl_saved)
+TEST_DECLARE   (loop_io_uring)
+TEST_DECLARE   (loop_io_uring_fs)
+TEST_DECLARE   (loop_io_uring_fs_cancel)
+TEST_DECLARE   (loop_io_uring_poll_many)
+TEST_DECLARE   (loop_io_uring_poll_many_nowait)
+TEST_DECLARE   (loop_busy_poll)
+TEST_DECLARE   (loop_poll_batch)
+TEST_DECLARE   (loop_metrics)
+TEST_DECLARE   (loop_lag)
+TEST_DECLARE   (loop_timer_wheel)
 TEST_DECLARE   (default_loop_close)
 TEST_DECLARE   (barrier_1)
 TEST_DECLARE   (barrier_2)
@@ -69,6 +83,7 @@ TEST_DECLARE   (tcp_open)
 TEST_DECLARE   (tcp_connect_error_after_write)
 TEST_DECLARE   (tcp_shutdown_after_write)
 TEST_DECLARE   (tcp_bind_error_addrinuse)
+TEST_DECLARE   (tcp_reuseport)
 TEST_DECLARE   (tcp_bind_error_addrnotavail_1)
 TEST_DECLARE   (tcp_bind_error_addrnotavail_2)
 TEST_DECLARE   (tcp_bind_error_fault)
@@ -95,6 +110,7 @@ TEST_DECLARE   (tcp_bind6_error_inval)
 TEST_DECLARE   (tcp_bind6_localhost_ok)
 TEST_DECLARE   (udp_bind)
 TEST_DECLARE   (udp_bind_reuseaddr)
+TEST_DECLARE   (udp_reuseport)
 TEST_DECLARE   (udp_send_and_recv)
 TEST_DECLARE   (udp_send_immediate)
 TEST_DECLARE   (udp_send_unreachable)
@@ -136,11 +152,15 @@ TEST_DECLARE   (timer_init)
 TEST_DECLARE   (timer_again)
 TEST_DECLARE   (timer_start_twice)
 TEST_DECLARE   (timer_order)
+TEST_DECLARE   (timer_order_many)
 TEST_DECLARE   (timer_huge_timeout)
 TEST_DECLARE   (timer_huge_repeat)
 TEST_DECLARE   (timer_run_once)
 TEST_DECLARE   (timer_from_check)
 TEST_DECLARE   (timer_null_callback)
+TEST_DECLARE   (timer_slack)
+TEST_DECLARE   (timer_ns)
+TEST_DECLARE   (timer_start_enomem)
 TEST_DECLARE   (idle_starvation)
 TEST_DECLARE   (loop_handles)
 TEST_DECLARE   (get_loadavg)
@@ -178,6 +198,12 @@ TEST_DECLARE   (active)
 TEST_DECLARE   (embed)
 TEST_DECLARE   (async)
 TEST_DECLARE   (async_null_cb)
+TEST_DECLARE   (async_close_pending)
+TEST_DECLARE   (async_many_handles)
+TEST_DECLARE   (channel)
+TEST_DECLARE   (channel_threads)
+TEST_DECLARE   (channel_close_in_cb)
+TEST_DECLARE   (channel_min_capacity)
 TEST_DECLARE   (get_currentexe)
 TEST_DECLARE   (process_title)
 TEST_DECLARE   (cwd_and_chdir)
@@ -264,6 +290,7 @@ TEST_DECLARE   (fs_scandir_file)
 TEST_DECLARE   (fs_open_dir)
 TEST_DECLARE   (fs_rename_to_existing_file)
 TEST_DECLARE   (fs_write_multiple_bufs)
+TEST_DECLARE   (fs_write_serial)
 TEST_DECLARE   (threadpool_queue_work_simple)
 TEST_DECLARE   (threadpool_queue_work_einval)
 TEST_DECLARE   (threadpool_multiple_event_loops)
@@ -272,10 +299,17 @@ TEST_DECLARE   (threadpool_cancel_getnameinfo)
 TEST_DECLARE   (threadpool_cancel_work)
 TEST_DECLARE   (threadpool_cancel_fs)
 TEST_DECLARE   (threadpool_cancel_single)
+TEST_DECLARE   (threadpool_work_kinds)
+TEST_DECLARE   (threadpool_resize)
+TEST_DECLARE   (threadpool_stats)
+TEST_DECLARE   (threadpool_queue_work_many)
+TEST_DECLARE   (threadpool_serial)
+TEST_DECLARE   (threadpool_serial_cancel)
 TEST_DECLARE   (thread_local_storage)
 TEST_DECLARE   (thread_mutex)
 TEST_DECLARE   (thread_rwlock)
 TEST_DECLARE   (thread_create)
+TEST_DECLARE   (thread_create_ex)
 TEST_DECLARE   (thread_equal)
 TEST_DECLARE   (dlerror)
 TEST_DECLARE   (poll_duplex)
@@ -330,7 +364,21 @@ TASK_LIST_START
   TEST_ENTRY  (loop_stop)
   TEST_ENTRY  (loop_update_time)
   TEST_ENTRY  (loop_backend_timeout)
+  TEST_ENTRY  (loop_clock_mode)
   TEST_ENTRY  (loop_configure)
+  TEST_ENTRY  (loop_edge_triggered_tcp)
+  TEST_ENTRY  (loop_edge_triggered_udp)
+  TEST_ENTRY  (loop_edge_triggered_ctl_saved)
+  TEST_ENTRY  (loop_io_uring)
+  TEST_ENTRY  (loop_io_uring_fs)
+  TEST_ENTRY  (loop_io_uring_fs_cancel)
+  TEST_ENTRY  (loop_io_uring_poll_many)
+  TEST_ENTRY  (loop_io_uring_poll_many_nowait)
+  TEST_ENTRY  (loop_busy_poll)
+  TEST_ENTRY  (loop_poll_batch)
+  TEST_ENTRY  (loop_metrics)
+  TEST_ENTRY  (loop_lag)
+  TEST_ENTRY  (loop_timer_wheel)
   TEST_ENTRY  (default_loop_close)
   TEST_ENTRY  (barrier_1)
   TEST_ENTRY  (barrier_2)
@@ -399,6 +447,7 @@ TASK_LIST_START
 
   TEST_ENTRY  (tcp_connect_error_after_write)
   TEST_ENTRY  (tcp_bind_error_addrinuse)
+  TEST_ENTRY  (tcp_reuseport)
   TEST_ENTRY  (tcp_bind_error_addrnotavail_1)
   TEST_ENTRY  (tcp_bind_error_addrnotavail_2)
   TEST_ENTRY  (tcp_bind_error_fault)
@@ -429,6 +478,7 @@ TASK_LIST_START
 
   TEST_ENTRY  (udp_bind)
   TEST_ENTRY  (udp_bind_reuseaddr)
+  TEST_ENTRY  (udp_reuseport)
   TEST_ENTRY  (udp_send_and_recv)
   TEST_ENTRY  (udp_send_immediate)
   TEST_ENTRY  (udp_send_unreachable)
@@ -481,11 +531,15 @@ TASK_LIST_START
   TEST_ENTRY  (timer_again)
   TEST_ENTRY  (timer_start_twice)
   TEST_ENTRY  (timer_order)
+  TEST_ENTRY  (timer_order_many)
   TEST_ENTRY  (timer_huge_timeout)
   TEST_ENTRY  (timer_huge_repeat)
   TEST_ENTRY  (timer_run_once)
   TEST_ENTRY  (timer_from_check)
   TEST_ENTRY  (timer_null_callback)
+  TEST_ENTRY  (timer_slack)
+  TEST_ENTRY  (timer_ns)
+  TEST_ENTRY  (timer_start_enomem)
 
   TEST_ENTRY  (idle_starvation)
 
@@ -530,6 +584,12 @@ TASK_LIST_START
 
   TEST_ENTRY  (async)
   TEST_ENTRY  (async_null_cb)
+  TEST_ENTRY  (async_close_pending)
+  TEST_ENTRY  (async_many_handles)
+  TEST_ENTRY  (channel)
+  TEST_ENTRY  (channel_threads)
+  TEST_ENTRY  (channel_close_in_cb)
+  TEST_ENTRY  (channel_min_capacity)
 
   TEST_ENTRY  (get_currentexe)
 
@@ -660,6 +720,7 @@ TASK_LIST_START
   TEST_ENTRY  (fs_open_dir)
   TEST_ENTRY  (fs_rename_to_existing_file)
   TEST_ENTRY  (fs_write_multiple_bufs)
+  TEST_ENTRY  (fs_write_serial)
   TEST_ENTRY  (threadpool_queue_work_simple)
   TEST_ENTRY  (threadpool_queue_work_einval)
   TEST_ENTRY  (threadpool_multiple_event_loops)
@@ -668,10 +729,17 @@ TASK_LIST_START
   TEST_ENTRY  (threadpool_cancel_work)
   TEST_ENTRY  (threadpool_cancel_fs)
   TEST_ENTRY  (threadpool_cancel_single)
+  TEST_ENTRY  (threadpool_work_kinds)
+  TEST_ENTRY  (threadpool_resize)
+  TEST_ENTRY  (threadpool_stats)
+  TEST_ENTRY  (threadpool_queue_work_many)
+  TEST_ENTRY  (threadpool_serial)
+  TEST_ENTRY  (threadpool_serial_cancel)
   TEST_ENTRY  (thread_local_storage)
   TEST_ENTRY  (thread_mutex)
   TEST_ENTRY  (thread_rwlock)
   TEST_ENTRY  (thread_create)
+  TEST_ENTRY  (thread_create_ex)
   TEST_ENTRY  (thread_equal)
   TEST_ENTRY  (dlerror)
   TEST_ENTRY  (ip4_addr)
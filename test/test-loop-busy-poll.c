@@ -0,0 +1,126 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define PINGS 16
+
+static uv_loop_t loop;
+static uv_udp_t server;
+static uv_udp_t client;
+static uv_udp_send_t send_req;
+static uv_timer_t timer;
+static struct sockaddr_in addr;
+static int recv_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[64];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  ASSERT(status == 0);
+}
+
+
+static void send_ping(uv_timer_t* handle) {
+  uv_buf_t buf;
+
+  buf = uv_buf_init("PING", 4);
+  ASSERT(0 == uv_udp_send(&send_req,
+                          &client,
+                          &buf,
+                          1,
+                          (const struct sockaddr*) &addr,
+                          send_cb));
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == 4);
+  ASSERT(0 == memcmp(buf->base, "PING", 4));
+
+  if (++recv_cb_called < PINGS) {
+    /* Leave the loop idle for a moment so it has to poll for the next one. */
+    ASSERT(0 == uv_timer_start(&timer, send_ping, 1, 0));
+    return;
+  }
+
+  uv_close((uv_handle_t*) &server, close_cb);
+  uv_close((uv_handle_t*) &client, close_cb);
+  uv_close((uv_handle_t*) &timer, close_cb);
+}
+
+
+TEST_IMPL(loop_busy_poll) {
+  uv_metrics_t metrics;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_BUSY_POLL, 100);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("Busy polling is only implemented on Linux.");
+#endif
+  ASSERT(r == 0);
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_BUSY_POLL, -1));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(&loop, &server));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+  ASSERT(0 == uv_udp_init(&loop, &client));
+  ASSERT(0 == uv_timer_init(&loop, &timer));
+
+  send_ping(&timer);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(recv_cb_called == PINGS);
+  ASSERT(close_cb_called == 3);
+  /* Every blocking poll either found something while spinning or gave up. */
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+  ASSERT(metrics.busy_poll_hits + metrics.busy_poll_misses > 0);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
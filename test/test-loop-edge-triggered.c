@@ -0,0 +1,283 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TOTAL_BYTES (4 * 1024 * 1024)
+#define DGRAMS 64
+
+static uv_loop_t loop;
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t incoming;
+static uv_timer_t resume_timer;
+static uv_connect_t connect_req;
+static uv_write_t write_req;
+static uv_shutdown_t shutdown_req;
+static char* send_buffer;
+static size_t bytes_received;
+static int read_pauses;
+static int write_cb_called;
+static int close_cb_called;
+
+static uv_udp_t udp_server;
+static uv_udp_t udp_client;
+static uv_udp_send_t send_reqs[DGRAMS];
+static int send_cb_called;
+static int recv_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+
+
+static void resume_cb(uv_timer_t* handle) {
+  /* Nothing new arrives while the sender is stuck on a full socket buffer,
+   * so there is no edge to wake us up. The loop has to remember that the
+   * fd was still readable when we stopped.
+   */
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread == UV_EOF) {
+    uv_close((uv_handle_t*) stream, close_cb);
+    uv_close((uv_handle_t*) &client, close_cb);
+    uv_close((uv_handle_t*) &server, close_cb);
+    uv_close((uv_handle_t*) &resume_timer, close_cb);
+    return;
+  }
+
+  ASSERT(nread >= 0);
+  bytes_received += nread;
+
+  if (nread > 0 && read_pauses < 3) {
+    read_pauses++;
+    ASSERT(0 == uv_read_stop(stream));
+    ASSERT(0 == uv_timer_start(&resume_timer, resume_cb, 10, 0));
+  }
+}
+
+
+static void connection_cb(uv_stream_t* stream, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(&loop, &incoming));
+  ASSERT(0 == uv_accept(stream, (uv_stream_t*) &incoming));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  write_cb_called++;
+}
+
+
+static void shutdown_cb(uv_shutdown_t* req, int status) {
+  ASSERT(status == 0);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+  buf = uv_buf_init(send_buffer, TOTAL_BYTES);
+  ASSERT(0 == uv_write(&write_req, req->handle, &buf, 1, write_cb));
+  ASSERT(0 == uv_shutdown(&shutdown_req, req->handle, shutdown_cb));
+}
+
+
+TEST_IMPL(loop_edge_triggered_tcp) {
+  struct sockaddr_in addr;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_EDGE_TRIGGERED);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("Edge-triggered mode is only implemented on Linux.");
+#endif
+  ASSERT(r == 0);
+
+  send_buffer = calloc(1, TOTAL_BYTES);
+  ASSERT(send_buffer != NULL);
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_timer_init(&loop, &resume_timer));
+  ASSERT(0 == uv_tcp_init(&loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_tcp_init(&loop, &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(write_cb_called == 1);
+  ASSERT(read_pauses == 3);
+  ASSERT(bytes_received == TOTAL_BYTES);
+  ASSERT(close_cb_called == 4);
+
+  free(send_buffer);
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
+
+
+static void send_cb(uv_udp_send_t* req, int status) {
+  ASSERT(status == 0);
+  send_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == 4);
+  ASSERT(0 == memcmp(buf->base, "PING", 4));
+
+  if (++recv_cb_called == DGRAMS) {
+    uv_close((uv_handle_t*) &udp_server, close_cb);
+    uv_close((uv_handle_t*) &udp_client, close_cb);
+  }
+}
+
+
+TEST_IMPL(loop_edge_triggered_udp) {
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+  int r;
+  int i;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_EDGE_TRIGGERED);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("Edge-triggered mode is only implemented on Linux.");
+#endif
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(&loop, &udp_server));
+  ASSERT(0 == uv_udp_bind(&udp_server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&udp_server, alloc_cb, recv_cb));
+  ASSERT(0 == uv_udp_init(&loop, &udp_client));
+
+  buf = uv_buf_init("PING", 4);
+  for (i = 0; i < DGRAMS; i++)
+    ASSERT(0 == uv_udp_send(send_reqs + i,
+                            &udp_client,
+                            &buf,
+                            1,
+                            (const struct sockaddr*) &addr,
+                            send_cb));
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(send_cb_called == DGRAMS);
+  ASSERT(recv_cb_called == DGRAMS);
+  ASSERT(close_cb_called == 2);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
+
+
+static void noop_recv_cb(uv_udp_t* handle,
+                         ssize_t nread,
+                         const uv_buf_t* buf,
+                         const struct sockaddr* addr,
+                         unsigned flags) {
+}
+
+
+TEST_IMPL(loop_edge_triggered_ctl_saved) {
+  struct sockaddr_in addr;
+  uv_metrics_t before;
+  uv_metrics_t after;
+  int r;
+  int i;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_EDGE_TRIGGERED);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("Edge-triggered mode is only implemented on Linux.");
+#endif
+  ASSERT(r == 0);
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(&loop, &udp_server));
+  ASSERT(0 == uv_udp_bind(&udp_server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&udp_server, alloc_cb, noop_recv_cb));
+  uv_run(&loop, UV_RUN_NOWAIT);
+
+  /* The watcher is registered now, toggling it doesn't touch epoll. */
+  ASSERT(0 == uv_loop_metrics(&loop, &before));
+  for (i = 0; i < 10; i++) {
+    ASSERT(0 == uv_udp_recv_stop(&udp_server));
+    uv_run(&loop, UV_RUN_NOWAIT);
+    ASSERT(0 == uv_udp_recv_start(&udp_server, alloc_cb, noop_recv_cb));
+    uv_run(&loop, UV_RUN_NOWAIT);
+  }
+  ASSERT(0 == uv_loop_metrics(&loop, &after));
+
+  ASSERT(after.backend_ctl == before.backend_ctl);
+  ASSERT(after.backend_ctl_saved - before.backend_ctl_saved == 20);
+
+  uv_close((uv_handle_t*) &udp_server, close_cb);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(close_cb_called == 1);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
@@ -0,0 +1,439 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+# include <sys/resource.h>
+# include <unistd.h>
+#endif
+
+#define TOTAL_BYTES (4 * 1024 * 1024)
+
+static uv_loop_t loop;
+static uv_tcp_t server;
+static uv_tcp_t client;
+static uv_tcp_t incoming;
+static uv_timer_t resume_timer;
+static uv_connect_t connect_req;
+static uv_write_t write_req;
+static uv_shutdown_t shutdown_req;
+static char* send_buffer;
+static size_t bytes_received;
+static int read_pauses;
+static int write_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[65536];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+
+
+static void resume_cb(uv_timer_t* handle) {
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+}
+
+
+static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread == UV_EOF) {
+    uv_close((uv_handle_t*) stream, close_cb);
+    uv_close((uv_handle_t*) &client, close_cb);
+    uv_close((uv_handle_t*) &server, close_cb);
+    uv_close((uv_handle_t*) &resume_timer, close_cb);
+    return;
+  }
+
+  ASSERT(nread >= 0);
+  bytes_received += nread;
+
+  if (nread > 0 && read_pauses < 3) {
+    read_pauses++;
+    ASSERT(0 == uv_read_stop(stream));
+    ASSERT(0 == uv_timer_start(&resume_timer, resume_cb, 10, 0));
+  }
+}
+
+
+static void connection_cb(uv_stream_t* stream, int status) {
+  ASSERT(status == 0);
+  ASSERT(0 == uv_tcp_init(&loop, &incoming));
+  ASSERT(0 == uv_accept(stream, (uv_stream_t*) &incoming));
+  ASSERT(0 == uv_read_start((uv_stream_t*) &incoming, alloc_cb, read_cb));
+}
+
+
+static void write_cb(uv_write_t* req, int status) {
+  ASSERT(status == 0);
+  write_cb_called++;
+}
+
+
+static void shutdown_cb(uv_shutdown_t* req, int status) {
+  ASSERT(status == 0);
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  uv_buf_t buf;
+
+  ASSERT(status == 0);
+  buf = uv_buf_init(send_buffer, TOTAL_BYTES);
+  ASSERT(0 == uv_write(&write_req, req->handle, &buf, 1, write_cb));
+  ASSERT(0 == uv_shutdown(&shutdown_req, req->handle, shutdown_cb));
+}
+
+
+static void transfer(void) {
+  struct sockaddr_in addr;
+
+  bytes_received = 0;
+  read_pauses = 0;
+  write_cb_called = 0;
+  close_cb_called = 0;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_timer_init(&loop, &resume_timer));
+  ASSERT(0 == uv_tcp_init(&loop, &server));
+  ASSERT(0 == uv_tcp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_listen((uv_stream_t*) &server, 128, connection_cb));
+
+  ASSERT(0 == uv_tcp_init(&loop, &client));
+  ASSERT(0 == uv_tcp_connect(&connect_req,
+                             &client,
+                             (const struct sockaddr*) &addr,
+                             connect_cb));
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(write_cb_called == 1);
+  ASSERT(read_pauses == 3);
+  ASSERT(bytes_received == TOTAL_BYTES);
+  ASSERT(close_cb_called == 4);
+}
+
+
+TEST_IMPL(loop_io_uring) {
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_USE_IO_URING);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("io_uring is only available on Linux.");
+#endif
+  /* Falls back to epoll on kernels without io_uring. */
+  ASSERT(r == 0);
+
+  send_buffer = calloc(1, TOTAL_BYTES);
+  ASSERT(send_buffer != NULL);
+
+  /* The second round binds the same port again.  That only works if closing
+   * the listen socket also released the poll request that referenced it.
+   */
+  transfer();
+  transfer();
+
+  free(send_buffer);
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
+
+
+static uv_fs_t fs_req;
+static uv_file fs_file;
+static char fs_buf[64];
+static int fs_step;
+
+
+static void fs_cb(uv_fs_t* req) {
+  uv_buf_t buf;
+
+  ASSERT(req == &fs_req);
+
+  switch (fs_step++) {
+  case 0:  /* open */
+    ASSERT(req->result >= 0);
+    fs_file = req->result;
+    uv_fs_req_cleanup(req);
+    buf = uv_buf_init("hello io_uring", 14);
+    ASSERT(0 == uv_fs_write(&loop, req, fs_file, &buf, 1, 0, fs_cb));
+    break;
+  case 1:  /* write */
+    ASSERT(req->result == 14);
+    uv_fs_req_cleanup(req);
+    ASSERT(0 == uv_fs_fsync(&loop, req, fs_file, fs_cb));
+    break;
+  case 2:  /* fsync */
+    ASSERT(req->result == 0);
+    uv_fs_req_cleanup(req);
+    ASSERT(0 == uv_fs_fdatasync(&loop, req, fs_file, fs_cb));
+    break;
+  case 3:  /* fdatasync */
+    ASSERT(req->result == 0);
+    uv_fs_req_cleanup(req);
+    ASSERT(0 == uv_fs_fstat(&loop, req, fs_file, fs_cb));
+    break;
+  case 4:  /* fstat */
+    ASSERT(req->result == 0);
+    ASSERT(req->ptr == &req->statbuf);
+    ASSERT(req->statbuf.st_size == 14);
+    uv_fs_req_cleanup(req);
+    buf = uv_buf_init(fs_buf, sizeof(fs_buf));
+    ASSERT(0 == uv_fs_read(&loop, req, fs_file, &buf, 1, 6, fs_cb));
+    break;
+  case 5:  /* read */
+    ASSERT(req->result == 8);
+    ASSERT(0 == memcmp(fs_buf, "io_uring", 8));
+    uv_fs_req_cleanup(req);
+    ASSERT(0 == uv_fs_close(&loop, req, fs_file, fs_cb));
+    break;
+  case 6:  /* close */
+    ASSERT(req->result == 0);
+    uv_fs_req_cleanup(req);
+    ASSERT(0 == uv_fs_stat(&loop, req, "test_file", fs_cb));
+    break;
+  case 7:  /* stat */
+    ASSERT(req->result == 0);
+    ASSERT(req->statbuf.st_size == 14);
+    ASSERT((req->statbuf.st_mode & S_IFMT) == S_IFREG);
+    uv_fs_req_cleanup(req);
+    ASSERT(0 == uv_fs_stat(&loop, req, "no_such_file", fs_cb));
+    break;
+  case 8:  /* stat */
+    ASSERT(req->result == UV_ENOENT);
+    ASSERT(req->ptr == NULL);
+    uv_fs_req_cleanup(req);
+    break;
+  default:
+    ASSERT(0 && "unreachable");
+  }
+}
+
+
+TEST_IMPL(loop_io_uring_fs) {
+  uv_fs_t req;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_USE_IO_URING);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("io_uring is only available on Linux.");
+#endif
+  ASSERT(r == 0);
+
+  uv_fs_unlink(&loop, &req, "test_file", NULL);
+  uv_fs_req_cleanup(&req);
+
+  ASSERT(0 == uv_fs_open(&loop,
+                         &fs_req,
+                         "test_file",
+                         O_RDWR | O_CREAT,
+                         S_IWUSR | S_IRUSR,
+                         fs_cb));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(fs_step == 9);
+
+  ASSERT(0 == uv_fs_unlink(&loop, &req, "test_file", NULL));
+  uv_fs_req_cleanup(&req);
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
+
+
+static int cancel_cb_called;
+static int cancel_status;
+
+
+static void cancel_cb(uv_fs_t* req) {
+  cancel_status = req->result;
+  cancel_cb_called++;
+  uv_fs_req_cleanup(req);
+}
+
+
+TEST_IMPL(loop_io_uring_fs_cancel) {
+  uv_fs_t* req;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_USE_IO_URING);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("io_uring is only available on Linux.");
+#endif
+  ASSERT(r == 0);
+
+  /* Garbage in the fields that only the threadpool fills in. */
+  req = malloc(sizeof(*req));
+  ASSERT(req != NULL);
+  memset(req, 0x5a, sizeof(*req));
+
+  /* The loop hasn't handed it to the kernel yet. */
+  ASSERT(0 == uv_fs_stat(&loop, req, ".", cancel_cb));
+  ASSERT(0 == uv_cancel((uv_req_t*) req));
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(cancel_cb_called == 1);
+  ASSERT(cancel_status == UV_ECANCELED);
+
+  /* Too late once it's done. */
+  ASSERT(0 == uv_fs_stat(&loop, req, ".", cancel_cb));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(cancel_cb_called == 2);
+  ASSERT(cancel_status == 0);
+  ASSERT(UV_EBUSY == uv_cancel((uv_req_t*) req));
+
+  free(req);
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
+
+
+#if defined(__linux__)
+
+#define MAX_POLL_FDS 1500
+
+static uv_poll_t poll_handles[MAX_POLL_FDS];
+static int poll_fds[MAX_POLL_FDS][2];
+static unsigned int poll_fired[MAX_POLL_FDS];
+
+
+static void many_poll_cb(uv_poll_t* handle, int status, int events) {
+  ASSERT(status == 0);
+  ASSERT(events & UV_READABLE);
+  poll_fired[handle - poll_handles]++;
+}
+
+
+static void idle_cb(uv_idle_t* handle) {
+  /* Keeps the poll timeout at zero. */
+}
+
+
+static void stop_cb(uv_timer_t* handle) {
+  uv_stop(handle->loop);
+}
+
+
+/* More readable fds than fit into the completion queue at once.  Every one
+ * of them has to keep firing.
+ */
+static int poll_many(unsigned int nfds, uv_run_mode mode) {
+  struct rlimit lim;
+  uv_timer_t timer;
+  uv_idle_t idle;
+  unsigned int i;
+
+  ASSERT(nfds <= MAX_POLL_FDS);
+
+  ASSERT(0 == getrlimit(RLIMIT_NOFILE, &lim));
+  if (lim.rlim_cur < 2 * nfds + 64) {
+    lim.rlim_cur = lim.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &lim);
+    ASSERT(0 == getrlimit(RLIMIT_NOFILE, &lim));
+    if (lim.rlim_cur < 2 * nfds + 64)
+      RETURN_SKIP("Not enough file descriptors.");
+  }
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_USE_IO_URING));
+
+  for (i = 0; i < nfds; i++) {
+    ASSERT(0 == pipe(poll_fds[i]));
+    ASSERT(1 == write(poll_fds[i][1], "x", 1));
+    poll_fired[i] = 0;
+    ASSERT(0 == uv_poll_init(&loop, poll_handles + i, poll_fds[i][0]));
+    ASSERT(0 == uv_poll_start(poll_handles + i, UV_READABLE, many_poll_cb));
+  }
+
+  if (mode == UV_RUN_DEFAULT) {
+    ASSERT(0 == uv_idle_init(&loop, &idle));
+    ASSERT(0 == uv_idle_start(&idle, idle_cb));
+    ASSERT(0 == uv_timer_init(&loop, &timer));
+    ASSERT(0 == uv_timer_start(&timer, stop_cb, 300, 0));
+    uv_run(&loop, UV_RUN_DEFAULT);
+    uv_close((uv_handle_t*) &idle, NULL);
+    uv_close((uv_handle_t*) &timer, NULL);
+  } else {
+    for (i = 0; i < 20; i++)
+      uv_run(&loop, mode);
+  }
+
+  for (i = 0; i < nfds; i++)
+    ASSERT(poll_fired[i] > 1);
+
+  for (i = 0; i < nfds; i++)
+    uv_close((uv_handle_t*) (poll_handles + i), NULL);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  for (i = 0; i < nfds; i++) {
+    close(poll_fds[i][0]);
+    close(poll_fds[i][1]);
+  }
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
+
+
+#endif  /* defined(__linux__) */
+
+
+TEST_IMPL(loop_io_uring_poll_many) {
+#if defined(__linux__)
+  return poll_many(600, UV_RUN_DEFAULT);
+#else
+  RETURN_SKIP("io_uring is only available on Linux.");
+#endif
+}
+
+
+TEST_IMPL(loop_io_uring_poll_many_nowait) {
+#if defined(__linux__)
+  return poll_many(1500, UV_RUN_NOWAIT);
+#else
+  RETURN_SKIP("io_uring is only available on Linux.");
+#endif
+}
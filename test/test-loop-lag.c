@@ -0,0 +1,97 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+static uv_timer_t slow_timer;
+static uv_timer_t late_timer;
+static int timer_cb_called;
+
+
+static void slow_cb(uv_timer_t* handle) {
+  uint64_t start;
+
+  /* Block the loop for 20 ms. */
+  start = uv_hrtime();
+  while (uv_hrtime() - start < 20 * 1000000);
+
+  timer_cb_called++;
+}
+
+
+static void late_cb(uv_timer_t* handle) {
+  timer_cb_called++;
+}
+
+
+TEST_IMPL(loop_lag) {
+  uv_loop_t loop;
+  uint64_t value;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(UV_EINVAL == uv_loop_lag(&loop, UV_LAG_TIMER, 50, &value));
+
+  r = uv_loop_configure(&loop, UV_LOOP_LAG_HISTOGRAM);
+#ifdef _WIN32
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("The loop lag histogram is not implemented on Windows.");
+#endif
+  ASSERT(r == 0);
+
+  ASSERT(UV_EINVAL == uv_loop_lag(&loop, UV_LAG_TIMER, -1, &value));
+  ASSERT(UV_EINVAL == uv_loop_lag(&loop, UV_LAG_TIMER, 101, &value));
+  ASSERT(0 == uv_loop_lag(&loop, UV_LAG_TIMER, 50, &value));
+  ASSERT(value == 0);
+
+  ASSERT(0 == uv_timer_init(&loop, &slow_timer));
+  ASSERT(0 == uv_timer_init(&loop, &late_timer));
+  ASSERT(0 == uv_timer_start(&slow_timer, slow_cb, 5, 0));
+  ASSERT(0 == uv_timer_start(&late_timer, late_cb, 10, 0));
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(timer_cb_called == 2);
+
+  /* The second timer was due while the first one blocked the loop. */
+  ASSERT(0 == uv_loop_lag(&loop, UV_LAG_TIMER, 100, &value));
+  ASSERT(value >= 14 * 1000000);
+  ASSERT(0 == uv_loop_lag(&loop, UV_LAG_TIMER, 0, &value));
+  ASSERT(value < 14 * 1000000);
+
+  /* Waiting for the first timer doesn't count, running it does. */
+  ASSERT(0 == uv_loop_lag(&loop, UV_LAG_ITERATION, 100, &value));
+  ASSERT(value >= 19 * 1000000);
+  ASSERT(value < 1000 * 1000000);
+
+  ASSERT(0 == uv_loop_lag_reset(&loop));
+  ASSERT(0 == uv_loop_lag(&loop, UV_LAG_TIMER, 100, &value));
+  ASSERT(value == 0);
+  ASSERT(0 == uv_loop_lag(&loop, UV_LAG_ITERATION, 99.9, &value));
+  ASSERT(value == 0);
+
+  uv_close((uv_handle_t*) &slow_timer, NULL);
+  uv_close((uv_handle_t*) &late_timer, NULL);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
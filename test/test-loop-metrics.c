@@ -0,0 +1,129 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+static uv_loop_t loop;
+static uv_udp_t server;
+static uv_udp_t client;
+static uv_timer_t timer;
+static int recv_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[64];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == 4);
+  recv_cb_called++;
+  uv_close((uv_handle_t*) &server, close_cb);
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+static void timer_cb(uv_timer_t* handle) {
+  struct sockaddr_in addr;
+  uv_buf_t buf;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  buf = uv_buf_init("PING", 4);
+  ASSERT(4 == uv_udp_try_send(&client,
+                              &buf,
+                              1,
+                              (const struct sockaddr*) &addr));
+  uv_close((uv_handle_t*) handle, close_cb);
+}
+
+
+TEST_IMPL(loop_metrics) {
+  struct sockaddr_in addr;
+  uv_metrics_t metrics;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_metrics(&loop, &metrics);
+#ifdef _WIN32
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("Loop metrics are not implemented on Windows.");
+#endif
+  ASSERT(r == 0);
+  ASSERT(metrics.loop_count == 0);
+  ASSERT(metrics.callbacks == 0);
+  ASSERT(metrics.idle_time == 0);
+
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_METRICS_TIME));
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+  ASSERT(0 == uv_udp_init(&loop, &server));
+  ASSERT(0 == uv_udp_bind(&server, (const struct sockaddr*) &addr, 0));
+  ASSERT(0 == uv_udp_recv_start(&server, alloc_cb, recv_cb));
+  ASSERT(0 == uv_udp_init(&loop, &client));
+  ASSERT(0 == uv_timer_init(&loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb, 20, 0));
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(recv_cb_called == 1);
+  ASSERT(close_cb_called == 3);
+
+  ASSERT(0 == uv_loop_metrics(&loop, &metrics));
+  ASSERT(metrics.loop_count > 0);
+  ASSERT(metrics.polls > 0);
+  ASSERT(metrics.events > 0);
+  /* The timer, the read and three close callbacks. */
+  ASSERT(metrics.callbacks >= metrics.events + 4);
+
+  /* Most of the time is spent waiting for the timer. */
+  ASSERT(metrics.idle_time >= 10 * 1000000);
+  ASSERT(metrics.loop_time >= metrics.idle_time);
+  ASSERT(metrics.loop_time >= metrics.idle_time +
+                              metrics.timers_time +
+                              metrics.pending_time +
+                              metrics.prepare_time +
+                              metrics.poll_time +
+                              metrics.check_time +
+                              metrics.closing_time);
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
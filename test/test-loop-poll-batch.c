@@ -0,0 +1,143 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <string.h>
+
+#define NSOCKETS 128
+
+static uv_loop_t loop;
+static uv_udp_t servers[NSOCKETS];
+static uv_udp_t client;
+static int recv_cb_called;
+static int close_cb_called;
+
+
+static void alloc_cb(uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+  static char slab[64];
+  buf->base = slab;
+  buf->len = sizeof(slab);
+}
+
+
+static void close_cb(uv_handle_t* handle) {
+  close_cb_called++;
+}
+
+
+static void recv_cb(uv_udp_t* handle,
+                    ssize_t nread,
+                    const uv_buf_t* buf,
+                    const struct sockaddr* addr,
+                    unsigned flags) {
+  int i;
+
+  if (nread == 0)
+    return;
+
+  ASSERT(nread == 4);
+  ASSERT(0 == memcmp(buf->base, "PING", 4));
+  ASSERT(0 == uv_udp_recv_stop(handle));
+
+  if (++recv_cb_called < NSOCKETS)
+    return;
+
+  for (i = 0; i < NSOCKETS; i++)
+    uv_close((uv_handle_t*) &servers[i], close_cb);
+  uv_close((uv_handle_t*) &client, close_cb);
+}
+
+
+/* Make all sockets readable at once, then see that every one of them is
+ * serviced no matter how many events a single poll returns.
+ */
+static void ping_all(void) {
+  struct sockaddr_storage addr;
+  struct sockaddr_in bind_addr;
+  uv_buf_t buf;
+  int namelen;
+  int i;
+
+  recv_cb_called = 0;
+  close_cb_called = 0;
+
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", 0, &bind_addr));
+  ASSERT(0 == uv_udp_init(&loop, &client));
+  buf = uv_buf_init("PING", 4);
+
+  for (i = 0; i < NSOCKETS; i++) {
+    ASSERT(0 == uv_udp_init(&loop, &servers[i]));
+    ASSERT(0 == uv_udp_bind(&servers[i],
+                            (const struct sockaddr*) &bind_addr,
+                            0));
+    ASSERT(0 == uv_udp_recv_start(&servers[i], alloc_cb, recv_cb));
+
+    namelen = sizeof(addr);
+    ASSERT(0 == uv_udp_getsockname(&servers[i],
+                                   (struct sockaddr*) &addr,
+                                   &namelen));
+    ASSERT(4 == uv_udp_try_send(&client,
+                                &buf,
+                                1,
+                                (const struct sockaddr*) &addr));
+  }
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(recv_cb_called == NSOCKETS);
+  ASSERT(close_cb_called == NSOCKETS + 1);
+}
+
+
+TEST_IMPL(loop_poll_batch) {
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_POLL_BATCH, 1, 1);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("The poll batch size is only configurable on Linux.");
+#endif
+  ASSERT(r == 0);
+
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_POLL_BATCH, -1, 1));
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_POLL_BATCH, 64, 0));
+
+  /* One event per poll and no second poll per loop iteration. */
+  ping_all();
+
+  /* Adaptive mode, starting with a buffer that's too small. */
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_POLL_BATCH, 64, 48));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_POLL_BATCH, 0, 48));
+  ping_all();
+#if defined(__linux__)
+  if (loop.iou == NULL)  /* io_uring doesn't use the buffer. */
+    ASSERT(loop.poll_batch > 64);
+#endif
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
@@ -61,3 +61,63 @@ TEST_IMPL(loop_backend_timeout) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+static void check_clock(uv_loop_t* loop) {
+  uint64_t prev;
+  uint64_t now;
+  uint64_t first;
+  uint64_t start;
+
+  start = uv_hrtime();
+  first = prev = uv_now_ns(loop);
+  ASSERT(uv_now_ns(loop) / 1000000 == uv_now(loop));
+
+  while (uv_hrtime() - start < 50 * 1000000) {
+    ASSERT(0 == uv_run(loop, UV_RUN_NOWAIT));
+    now = uv_now_ns(loop);
+    ASSERT(now >= prev);
+    ASSERT(now / 1000000 == uv_now(loop));
+    prev = now;
+  }
+
+  /* Even the coarse clock must have moved after 50 ms. */
+  ASSERT(prev - first >= 40 * 1000000);
+}
+
+
+TEST_IMPL(loop_clock_mode) {
+  uv_loop_t loop;
+  uint64_t before;
+  int r;
+
+  ASSERT(0 == uv_loop_init(&loop));
+
+  r = uv_loop_configure(&loop, UV_LOOP_CLOCK_MODE, UV_CLOCK_MODE_PRECISE);
+#ifdef _WIN32
+  ASSERT(r == UV_ENOSYS);
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("Clock modes are not implemented on Windows.");
+#endif
+  ASSERT(r == 0);
+  check_clock(&loop);
+
+  before = uv_now_ns(&loop);
+  ASSERT(0 == uv_loop_configure(&loop,
+                                UV_LOOP_CLOCK_MODE,
+                                UV_CLOCK_MODE_FAST));
+  ASSERT(uv_now_ns(&loop) >= before);
+  check_clock(&loop);
+
+  before = uv_now_ns(&loop);
+  ASSERT(0 == uv_loop_configure(&loop,
+                                UV_LOOP_CLOCK_MODE,
+                                UV_CLOCK_MODE_DEFAULT));
+  ASSERT(uv_now_ns(&loop) >= before);
+  check_clock(&loop);
+
+  ASSERT(UV_EINVAL == uv_loop_configure(&loop, UV_LOOP_CLOCK_MODE, 42));
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
@@ -0,0 +1,143 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "uv.h"
+#include "task.h"
+
+#define NUM_TIMERS 256
+
+static uv_loop_t loop;
+static uv_timer_t timers[NUM_TIMERS];
+static uv_timer_t order_timers[3];
+static uv_timer_t repeat_timer;
+static uint64_t last_timeout;
+static uint64_t last_start_id;
+static int timer_cb_called;
+static int order_cb_called;
+static int repeat_cb_called;
+
+
+static void timer_cb(uv_timer_t* handle) {
+#ifndef _WIN32
+  /* Same order as the binary heap: expiry time first, then start order. */
+  ASSERT(handle->timeout <= uv_now(&loop));
+  ASSERT(handle->timeout >= last_timeout);
+  if (handle->timeout == last_timeout)
+    ASSERT(handle->start_id > last_start_id);
+  last_timeout = handle->timeout;
+  last_start_id = handle->start_id;
+#endif
+  timer_cb_called++;
+}
+
+
+static void order_cb(uv_timer_t* handle) {
+  static uv_timer_t* const expected[] = {
+    order_timers + 1, order_timers + 2, order_timers + 0
+  };
+
+  ASSERT(handle == expected[order_cb_called]);
+  order_cb_called++;
+}
+
+
+static void repeat_cb(uv_timer_t* handle) {
+  if (++repeat_cb_called == 5)
+    uv_timer_stop(handle);
+}
+
+
+TEST_IMPL(loop_timer_wheel) {
+  uv_timer_t timer;
+  unsigned int seed;
+  int i;
+  int r;
+
+  /* Can't switch once timers are queued. */
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_timer_init(&loop, &timer));
+  ASSERT(0 == uv_timer_start(&timer, timer_cb, 1000, 0));
+  r = uv_loop_configure(&loop, UV_LOOP_TIMER_WHEEL);
+#ifdef _WIN32
+  ASSERT(r == UV_ENOSYS);
+  uv_close((uv_handle_t*) &timer, NULL);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+  RETURN_SKIP("The timer wheel is not implemented on Windows.");
+#endif
+  ASSERT(r == UV_EBUSY);
+  uv_close((uv_handle_t*) &timer, NULL);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_loop_configure(&loop, UV_LOOP_TIMER_WHEEL));
+
+  /* Timers that expire together run in start order, restarting moves a
+   * timer to the back.
+   */
+  for (i = 0; i < 3; i++) {
+    ASSERT(0 == uv_timer_init(&loop, order_timers + i));
+    ASSERT(0 == uv_timer_start(order_timers + i, order_cb, 10, 0));
+  }
+  ASSERT(0 == uv_timer_start(order_timers + 0, order_cb, 10, 0));
+
+  ASSERT(0 == uv_timer_init(&loop, &repeat_timer));
+  ASSERT(0 == uv_timer_start(&repeat_timer, repeat_cb, 1, 20));
+
+  /* Churn: the timeouts span the first two levels of the wheel, timers get
+   * restarted and stopped at random.
+   */
+  seed = 42;
+  for (i = 0; i < NUM_TIMERS; i++) {
+    seed = seed * 1103515245 + 12345;
+    ASSERT(0 == uv_timer_init(&loop, timers + i));
+    ASSERT(0 == uv_timer_start(timers + i, timer_cb, (seed >> 16) % 150, 0));
+  }
+
+  for (i = 0; i < NUM_TIMERS * 4; i++) {
+    seed = seed * 1103515245 + 12345;
+    if ((seed >> 16) % 8 == 0)
+      ASSERT(0 == uv_timer_stop(timers + (seed >> 8) % NUM_TIMERS));
+    else
+      ASSERT(0 == uv_timer_start(timers + (seed >> 8) % NUM_TIMERS,
+                                 timer_cb,
+                                 (seed >> 16) % 150,
+                                 0));
+  }
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(order_cb_called == 3);
+  ASSERT(repeat_cb_called == 5);
+  ASSERT(timer_cb_called > 0);
+  ASSERT(timer_cb_called < NUM_TIMERS);
+
+  for (i = 0; i < NUM_TIMERS; i++)
+    uv_close((uv_handle_t*) (timers + i), NULL);
+  for (i = 0; i < 3; i++)
+    uv_close((uv_handle_t*) (order_timers + i), NULL);
+  uv_close((uv_handle_t*) &repeat_timer, NULL);
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+
+  ASSERT(0 == uv_loop_close(&loop));
+  return 0;
+}
@@ -0,0 +1,164 @@
+/* Copyright Joyent, Inc. and other Node contributors. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "uv.h"
+#include "task.h"
+
+#include <stdlib.h>
+
+#define NUM_CLIENTS 16
+
+static uv_tcp_t servers[2];
+static uv_tcp_t clients[NUM_CLIENTS];
+static uv_connect_t connect_reqs[NUM_CLIENTS];
+static int connection_cb_called;
+static int connect_cb_called;
+
+
+static void close_all(void) {
+  int i;
+
+  uv_close((uv_handle_t*) &servers[0], NULL);
+  uv_close((uv_handle_t*) &servers[1], NULL);
+  for (i = 0; i < NUM_CLIENTS; i++)
+    uv_close((uv_handle_t*) &clients[i], NULL);
+}
+
+
+static void connection_cb(uv_stream_t* server, int status) {
+  uv_tcp_t* conn;
+
+  ASSERT(status == 0);
+  conn = malloc(sizeof(*conn));
+  ASSERT(conn != NULL);
+  ASSERT(0 == uv_tcp_init(server->loop, conn));
+  ASSERT(0 == uv_accept(server, (uv_stream_t*) conn));
+  uv_close((uv_handle_t*) conn, (uv_close_cb) free);
+
+  if (++connection_cb_called == NUM_CLIENTS && connect_cb_called == NUM_CLIENTS)
+    close_all();
+}
+
+
+static void connect_cb(uv_connect_t* req, int status) {
+  ASSERT(status == 0);
+
+  if (++connect_cb_called == NUM_CLIENTS && connection_cb_called == NUM_CLIENTS)
+    close_all();
+}
+
+
+TEST_IMPL(tcp_reuseport) {
+  struct sockaddr_in addr;
+  uv_tcp_t other;
+  uv_loop_t* loop;
+  int r;
+  int i;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_tcp_init(loop, &servers[0]));
+  r = uv_tcp_bind(&servers[0], (const struct sockaddr*) &addr, UV_TCP_REUSEPORT);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &servers[0], NULL);
+    uv_run(loop, UV_RUN_DEFAULT);
+    RETURN_SKIP("SO_REUSEPORT is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+  ASSERT(0 == uv_listen((uv_stream_t*) &servers[0], 128, connection_cb));
+
+  /* A socket without the flag can't join. */
+  ASSERT(0 == uv_tcp_init(loop, &other));
+  ASSERT(0 == uv_tcp_bind(&other, (const struct sockaddr*) &addr, 0));
+  ASSERT(UV_EADDRINUSE == uv_listen((uv_stream_t*) &other, 128, NULL));
+  uv_close((uv_handle_t*) &other, NULL);
+
+  ASSERT(0 == uv_tcp_init(loop, &servers[1]));
+  ASSERT(0 == uv_tcp_bind(&servers[1],
+                          (const struct sockaddr*) &addr,
+                          UV_TCP_REUSEPORT));
+  ASSERT(0 == uv_listen((uv_stream_t*) &servers[1], 128, connection_cb));
+
+  r = uv_reuseport_steer_cpu((uv_handle_t*) &servers[0], 2);
+  ASSERT(r == 0 || r == UV_ENOTSUP);
+  r = uv_incoming_cpu((uv_handle_t*) &servers[1], 0);
+  ASSERT(r == 0 || r == UV_ENOTSUP);
+
+  for (i = 0; i < NUM_CLIENTS; i++) {
+    ASSERT(0 == uv_tcp_init(loop, &clients[i]));
+    ASSERT(0 == uv_tcp_connect(&connect_reqs[i],
+                               &clients[i],
+                               (const struct sockaddr*) &addr,
+                               connect_cb));
+  }
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  ASSERT(connection_cb_called == NUM_CLIENTS);
+  ASSERT(connect_cb_called == NUM_CLIENTS);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+TEST_IMPL(udp_reuseport) {
+  struct sockaddr_in addr;
+  uv_udp_t handles[3];
+  uv_loop_t* loop;
+  int r;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_ip4_addr("127.0.0.1", TEST_PORT, &addr));
+
+  ASSERT(0 == uv_udp_init(loop, &handles[0]));
+  ASSERT(0 == uv_udp_init(loop, &handles[1]));
+  ASSERT(0 == uv_udp_init(loop, &handles[2]));
+
+  r = uv_udp_bind(&handles[0], (const struct sockaddr*) &addr, UV_UDP_REUSEPORT);
+  if (r == UV_ENOTSUP) {
+    uv_close((uv_handle_t*) &handles[0], NULL);
+    uv_close((uv_handle_t*) &handles[1], NULL);
+    uv_close((uv_handle_t*) &handles[2], NULL);
+    uv_run(loop, UV_RUN_DEFAULT);
+    RETURN_SKIP("SO_REUSEPORT is not supported on this platform.");
+  }
+  ASSERT(r == 0);
+  ASSERT(0 == uv_udp_bind(&handles[1],
+                          (const struct sockaddr*) &addr,
+                          UV_UDP_REUSEPORT));
+  ASSERT(UV_EADDRINUSE == uv_udp_bind(&handles[2],
+                                      (const struct sockaddr*) &addr,
+                                      0));
+
+  r = uv_reuseport_steer_cpu((uv_handle_t*) &handles[1], 2);
+  ASSERT(r == 0 || r == UV_ENOTSUP);
+  ASSERT(UV_EINVAL == uv_reuseport_steer_cpu((uv_handle_t*) &handles[1], 0));
+
+  uv_close((uv_handle_t*) &handles[0], NULL);
+  uv_close((uv_handle_t*) &handles[1], NULL);
+  uv_close((uv_handle_t*) &handles[2], NULL);
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
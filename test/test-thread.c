@@ -26,6 +26,10 @@
 #include <stdlib.h>
 #include <string.h> /* memset */
 
+#ifdef __linux__
+# include <sys/prctl.h>
+#endif
+
 struct getaddrinfo_req {
   uv_thread_t thread_id;
   unsigned int counter;
@@ -161,6 +165,77 @@ TEST_IMPL(thread_create) {
 }
 
 
+static void thread_ex_entry(void* arg) {
+#ifdef __linux__
+  char name[17];
+
+  memset(name, 0, sizeof(name));
+  ASSERT(0 == prctl(PR_GET_NAME, name, 0, 0, 0));
+  ASSERT(0 == strcmp(name, "uv-test-thread"));
+#endif
+  ASSERT(arg == (void *) 42);
+  thread_called++;
+}
+
+
+TEST_IMPL(thread_create_ex) {
+  uv_thread_options_t options;
+  uv_thread_t tid;
+  char* cpumask;
+  int mask_size;
+  int r;
+
+  thread_called = 0;
+
+  /* Too small a stack is rounded up to the platform minimum. */
+  options.flags = UV_THREAD_HAS_STACK_SIZE | UV_THREAD_HAS_NAME;
+  options.stack_size = 1;
+  options.name = "uv-test-thread";
+  ASSERT(0 == uv_thread_create_ex(&tid, &options, thread_ex_entry, (void *) 42));
+  ASSERT(0 == uv_thread_join(&tid));
+
+  options.stack_size = 16 * 1024 * 1024;
+  ASSERT(0 == uv_thread_create_ex(&tid, &options, thread_ex_entry, (void *) 42));
+  ASSERT(0 == uv_thread_join(&tid));
+  ASSERT(thread_called == 2);
+
+  mask_size = uv_cpumask_size();
+  if (mask_size == UV_ENOTSUP) {
+    options.flags = UV_THREAD_HAS_AFFINITY;
+    options.cpumask = "\1";
+    options.mask_size = 1;
+    r = uv_thread_create_ex(&tid, &options, thread_entry, (void *) 42);
+    ASSERT(r == UV_ENOTSUP);
+    ASSERT(UV_ENOTSUP == uv_threadpool_setaffinity("\1", 1));
+    RETURN_SKIP("CPU affinity is not supported on this platform.");
+  }
+  ASSERT(mask_size > 0);
+
+  cpumask = calloc(1, mask_size);
+  ASSERT(cpumask != NULL);
+
+  /* An empty mask is an error. */
+  options.flags = UV_THREAD_HAS_AFFINITY;
+  options.cpumask = cpumask;
+  options.mask_size = mask_size;
+  r = uv_thread_create_ex(&tid, &options, thread_entry, (void *) 42);
+  ASSERT(r == UV_EINVAL);
+  ASSERT(UV_EINVAL == uv_threadpool_setaffinity(cpumask, 0));
+
+  memset(cpumask, 1, mask_size);
+  ASSERT(0 == uv_thread_create_ex(&tid, &options, thread_entry, (void *) 42));
+  ASSERT(0 == uv_thread_join(&tid));
+  ASSERT(thread_called == 3);
+
+  tid = uv_thread_self();
+  ASSERT(0 == uv_thread_setaffinity(&tid, cpumask, mask_size));
+  ASSERT(0 == uv_threadpool_setaffinity(cpumask, mask_size));
+
+  free(cpumask);
+  return 0;
+}
+
+
 /* Hilariously bad test name. Run a lot of tasks in the thread pool and verify
  * that each "finished" callback is run in its originating thread.
  */
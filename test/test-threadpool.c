@@ -74,3 +74,433 @@ TEST_IMPL(threadpool_queue_work_einval) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+#define NUM_SLOW 8
+
+static uv_work_t slow_reqs[NUM_SLOW];
+static uv_work_t fast_req;
+static uv_sem_t slow_sem;
+static int slow_done;
+static int fast_done;
+
+
+static void slow_work_cb(uv_work_t* req) {
+  uv_sem_wait(&slow_sem);
+}
+
+
+static void slow_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  slow_done++;
+}
+
+
+static void fast_work_cb(uv_work_t* req) {
+  ASSERT(req == &fast_req);
+}
+
+
+static void fast_after_work_cb(uv_work_t* req, int status) {
+  int i;
+
+  ASSERT(status == 0);
+  ASSERT(slow_done == 0);
+  fast_done++;
+
+  for (i = 0; i < NUM_SLOW; i++)
+    uv_sem_post(&slow_sem);
+}
+
+
+TEST_IMPL(threadpool_work_kinds) {
+  int i;
+
+  ASSERT(UV_EINVAL == uv_queue_work_ex(uv_default_loop(),
+                                       &fast_req,
+                                       UV_WORK_KIND_MAX,
+                                       fast_work_cb,
+                                       fast_after_work_cb));
+
+  /* The slow requests block until the quick one is done.  They can't take
+   * all of the workers so the quick one gets to run.
+   */
+  ASSERT(0 == uv_sem_init(&slow_sem, 0));
+
+  for (i = 0; i < NUM_SLOW; i++)
+    ASSERT(0 == uv_queue_work_ex(uv_default_loop(),
+                                 slow_reqs + i,
+                                 UV_WORK_SLOW_IO,
+                                 slow_work_cb,
+                                 slow_after_work_cb));
+
+  ASSERT(0 == uv_queue_work_ex(uv_default_loop(),
+                               &fast_req,
+                               UV_WORK_FAST_IO,
+                               fast_work_cb,
+                               fast_after_work_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(fast_done == 1);
+  ASSERT(slow_done == NUM_SLOW);
+
+  uv_sem_destroy(&slow_sem);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#define NUM_BARRIER 6
+
+static uv_work_t barrier_reqs[NUM_BARRIER];
+static uv_barrier_t barrier;
+static int barrier_done;
+
+
+static void barrier_work_cb(uv_work_t* req) {
+  uv_barrier_wait(&barrier);
+}
+
+
+static void barrier_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  barrier_done++;
+}
+
+
+static void run_barrier(unsigned int count) {
+  unsigned int i;
+
+  ASSERT(count <= NUM_BARRIER);
+  ASSERT(0 == uv_barrier_init(&barrier, count));
+  barrier_done = 0;
+
+  for (i = 0; i < count; i++)
+    ASSERT(0 == uv_queue_work(uv_default_loop(),
+                              barrier_reqs + i,
+                              barrier_work_cb,
+                              barrier_after_work_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(barrier_done == (int) count);
+  uv_barrier_destroy(&barrier);
+}
+
+
+TEST_IMPL(threadpool_resize) {
+  ASSERT(UV_EINVAL == uv_threadpool_resize(0, 4));
+  ASSERT(UV_EINVAL == uv_threadpool_resize(4, 2));
+  ASSERT(UV_EINVAL == uv_threadpool_resize(1, 129));
+
+  /* Two workers, both have to run at the same time. */
+  ASSERT(0 == uv_threadpool_resize(2, 2));
+  run_barrier(2);
+
+  /* The requests only finish when there are NUM_BARRIER workers, the pool
+   * has to grow while all of its workers are blocked.
+   */
+  ASSERT(0 == uv_threadpool_resize(1, NUM_BARRIER));
+  run_barrier(NUM_BARRIER);
+
+  /* Shrinking leaves a working pool. */
+  ASSERT(0 == uv_threadpool_resize(1, 1));
+  run_barrier(1);
+
+  ASSERT(0 == uv_threadpool_resize(3, 3));
+  run_barrier(3);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#define NUM_EXTRA 3
+
+static uv_work_t stats_reqs[128 + NUM_EXTRA];
+static uv_sem_t stats_started;
+static uv_sem_t stats_release;
+static int stats_done;
+
+
+static void stats_work_cb(uv_work_t* req) {
+  uv_sem_post(&stats_started);
+  uv_sem_wait(&stats_release);
+}
+
+
+static void stats_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  stats_done++;
+}
+
+
+static uint64_t histogram_sum(const uint64_t* buckets, unsigned int from) {
+  uint64_t sum;
+
+  for (sum = 0; from < UV_THREADPOOL_HISTOGRAM_SIZE; from++)
+    sum += buckets[from];
+
+  return sum;
+}
+
+
+TEST_IMPL(threadpool_stats) {
+  const uv_threadpool_work_stats_t* before;
+  const uv_threadpool_work_stats_t* after;
+  uv_threadpool_stats_t s0;
+  uv_threadpool_stats_t s1;
+  uv_threadpool_stats_t s2;
+  unsigned int n;
+  unsigned int i;
+
+  ASSERT(UV_EINVAL == uv_threadpool_stats(NULL));
+  ASSERT(0 == uv_threadpool_stats_time(1));
+  ASSERT(0 == uv_threadpool_stats(&s0));
+  ASSERT(s0.nthreads > 0);
+
+  /* Every worker gets stuck on a request, the rest stays queued. */
+  n = s0.nthreads + NUM_EXTRA;
+  ASSERT(0 == uv_sem_init(&stats_started, 0));
+  ASSERT(0 == uv_sem_init(&stats_release, 0));
+
+  for (i = 0; i < n; i++)
+    ASSERT(0 == uv_queue_work(uv_default_loop(),
+                              stats_reqs + i,
+                              stats_work_cb,
+                              stats_after_work_cb));
+
+  for (i = 0; i < s0.nthreads; i++)
+    uv_sem_wait(&stats_started);
+
+  ASSERT(0 == uv_threadpool_stats(&s1));
+  ASSERT(s1.nthreads == s0.nthreads);
+  ASSERT(s1.nidle == 0);
+  ASSERT(s1.nqueued[UV_WORK_CPU] == NUM_EXTRA);
+  ASSERT(s1.nqueued[UV_WORK_FAST_IO] == 0);
+  ASSERT(s1.work[UV_WORK_CPU].submitted - s0.work[UV_WORK_CPU].submitted == n);
+
+  /* The queued ones wait at least 10 ms, bucket 14 starts at 8192 us. */
+  uv_sleep(10);
+
+  for (i = 0; i < n; i++)
+    uv_sem_post(&stats_release);
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(stats_done == (int) n);
+
+  ASSERT(0 == uv_threadpool_stats(&s2));
+  before = s0.work + UV_WORK_CPU;
+  after = s2.work + UV_WORK_CPU;
+  ASSERT(s2.nqueued[UV_WORK_CPU] == 0);
+  ASSERT(after->completed - before->completed == n);
+  ASSERT(histogram_sum(after->wait_time, 0) -
+         histogram_sum(before->wait_time, 0) == n);
+  ASSERT(histogram_sum(after->run_time, 0) -
+         histogram_sum(before->run_time, 0) == n);
+  ASSERT(histogram_sum(after->wait_time, 14) -
+         histogram_sum(before->wait_time, 14) >= NUM_EXTRA);
+  /* The first ones were blocked for the 10 ms too. */
+  ASSERT(histogram_sum(after->run_time, 14) -
+         histogram_sum(before->run_time, 14) >= s0.nthreads);
+
+  uv_sem_destroy(&stats_started);
+  uv_sem_destroy(&stats_release);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#define NUM_MANY 100
+
+static uv_work_t many_reqs[NUM_MANY];
+static int many_data[NUM_MANY];
+static int many_done;
+
+
+static void many_work_cb(uv_work_t* req) {
+  /* Every request writes only its own slot. */
+  many_data[req - many_reqs] = *(int*) req->data;
+}
+
+
+static void many_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(req->loop == uv_default_loop());
+  ASSERT(many_data[req - many_reqs] == (int) (req - many_reqs));
+  many_done++;
+}
+
+
+TEST_IMPL(threadpool_queue_work_many) {
+  static int values[NUM_MANY];
+  int i;
+
+  ASSERT(UV_EINVAL == uv_queue_work_many(uv_default_loop(),
+                                         many_reqs,
+                                         NUM_MANY,
+                                         UV_WORK_CPU,
+                                         NULL,
+                                         many_after_work_cb));
+  ASSERT(UV_EINVAL == uv_queue_work_many(uv_default_loop(),
+                                         many_reqs,
+                                         NUM_MANY,
+                                         UV_WORK_KIND_MAX,
+                                         many_work_cb,
+                                         many_after_work_cb));
+  ASSERT(0 == uv_queue_work_many(uv_default_loop(),
+                                 many_reqs,
+                                 0,
+                                 UV_WORK_CPU,
+                                 many_work_cb,
+                                 many_after_work_cb));
+
+  for (i = 0; i < NUM_MANY; i++) {
+    values[i] = i;
+    many_data[i] = -1;
+    many_reqs[i].data = values + i;
+  }
+
+  ASSERT(0 == uv_queue_work_many(uv_default_loop(),
+                                 many_reqs,
+                                 NUM_MANY,
+                                 UV_WORK_CPU,
+                                 many_work_cb,
+                                 many_after_work_cb));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(many_done == NUM_MANY);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#define NUM_SERIAL 50
+
+static uv_serial_t serial;
+static uv_work_t serial_reqs[NUM_SERIAL];
+static uv_work_t serial_other_req;
+static uv_sem_t serial_sem;
+static volatile int serial_running;
+static int serial_started;
+static int serial_done;
+
+
+static void serial_work_cb(uv_work_t* req) {
+  volatile int i;
+
+  ASSERT(serial_running == 0);
+  serial_running = 1;
+
+  ASSERT(req == serial_reqs + serial_started);
+  serial_started++;
+
+  /* Holds up the serial queue, but nothing else. */
+  if (req == serial_reqs)
+    uv_sem_wait(&serial_sem);
+
+  for (i = 0; i < 10000; i++);
+
+  serial_running = 0;
+}
+
+
+static void serial_after_work_cb(uv_work_t* req, int status) {
+  ASSERT(status == 0);
+  ASSERT(req == serial_reqs + serial_done);
+  serial_done++;
+
+  if (serial_done == NUM_SERIAL)
+    ASSERT(0 == uv_serial_destroy(&serial));
+}
+
+
+static void other_work_cb(uv_work_t* req) {
+  uv_sem_post(&serial_sem);
+}
+
+
+TEST_IMPL(threadpool_serial) {
+  int i;
+
+  ASSERT(0 == uv_sem_init(&serial_sem, 0));
+  ASSERT(0 == uv_serial_init(uv_default_loop(), &serial));
+
+  ASSERT(UV_EINVAL == uv_serial_queue_work(&serial,
+                                           serial_reqs,
+                                           NULL,
+                                           serial_after_work_cb));
+
+  for (i = 0; i < NUM_SERIAL; i++)
+    ASSERT(0 == uv_serial_queue_work(&serial,
+                                     serial_reqs + i,
+                                     serial_work_cb,
+                                     serial_after_work_cb));
+
+  ASSERT(UV_EBUSY == uv_serial_destroy(&serial));
+
+  /* The first request only finishes once this one ran, so the serial queue
+   * mustn't keep the other workers waiting.
+   */
+  ASSERT(0 == uv_queue_work(uv_default_loop(),
+                            &serial_other_req,
+                            other_work_cb,
+                            NULL));
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(serial_started == NUM_SERIAL);
+  ASSERT(serial_done == NUM_SERIAL);
+
+  uv_sem_destroy(&serial_sem);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static uv_work_t serial_cancel_reqs[3];
+static int serial_cancel_status[3];
+
+
+static void serial_cancel_work_cb(uv_work_t* req) {
+  uv_sem_wait(&serial_sem);
+}
+
+
+static void serial_cancel_after_work_cb(uv_work_t* req, int status) {
+  serial_cancel_status[req - serial_cancel_reqs] = status;
+}
+
+
+TEST_IMPL(threadpool_serial_cancel) {
+  unsigned int i;
+
+  ASSERT(0 == uv_sem_init(&serial_sem, 0));
+  ASSERT(0 == uv_serial_init(uv_default_loop(), &serial));
+
+  for (i = 0; i < ARRAY_SIZE(serial_cancel_reqs); i++) {
+    serial_cancel_status[i] = 1;
+    ASSERT(0 == uv_serial_queue_work(&serial,
+                                     serial_cancel_reqs + i,
+                                     serial_cancel_work_cb,
+                                     serial_cancel_after_work_cb));
+  }
+
+  /* The first one is running or about to, the others wait their turn. */
+  ASSERT(0 == uv_cancel((uv_req_t*) (serial_cancel_reqs + 1)));
+  uv_sem_post(&serial_sem);
+  uv_sem_post(&serial_sem);
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(serial_cancel_status[0] == 0);
+  ASSERT(serial_cancel_status[1] == UV_ECANCELED);
+  ASSERT(serial_cancel_status[2] == 0);
+  ASSERT(0 == uv_serial_destroy(&serial));
+
+  uv_sem_destroy(&serial_sem);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
@@ -161,6 +161,7 @@ TEST_IMPL(timer_init) {
 
   ASSERT(0 == uv_timer_init(uv_default_loop(), &handle));
   ASSERT(0 == uv_timer_get_repeat(&handle));
+  ASSERT(0 == uv_timer_get_slack(&handle));
   ASSERT(0 == uv_is_active((uv_handle_t*) &handle));
 
   MAKE_VALGRIND_HAPPY();
@@ -217,6 +218,65 @@ TEST_IMPL(timer_order) {
 }
 
 
+#define MANY_TIMERS 1000
+
+static uv_timer_t many_timers[MANY_TIMERS];
+static unsigned int many_due[MANY_TIMERS];
+static unsigned int many_seq[MANY_TIMERS];
+static unsigned int many_last_due;
+static unsigned int many_last_seq;
+static int many_cb_called;
+
+
+static void many_cb(uv_timer_t* handle) {
+  unsigned int i;
+
+  i = handle - many_timers;
+  ASSERT(i < MANY_TIMERS);
+
+  /* Ordered by timeout, then by the order in which they were started. */
+  ASSERT(many_due[i] >= many_last_due);
+  if (many_due[i] == many_last_due)
+    ASSERT(many_seq[i] > many_last_seq);
+
+  many_last_due = many_due[i];
+  many_last_seq = many_seq[i];
+  many_cb_called++;
+  uv_close((uv_handle_t*) handle, NULL);
+}
+
+
+TEST_IMPL(timer_order_many) {
+  unsigned int seq;
+  unsigned int i;
+
+  seq = 1;
+
+  for (i = 0; i < MANY_TIMERS; i++) {
+    many_due[i] = (i * 7919) % 17;
+    many_seq[i] = seq++;
+    ASSERT(0 == uv_timer_init(uv_default_loop(), many_timers + i));
+    ASSERT(0 == uv_timer_start(many_timers + i, many_cb, many_due[i], 0));
+  }
+
+  /* Restart every third timer with a different timeout, so that elements
+   * get removed from and reinserted into the middle of the timer queue.
+   */
+  for (i = 0; i < MANY_TIMERS; i += 3) {
+    ASSERT(0 == uv_timer_stop(many_timers + i));
+    many_due[i] = (i * 31) % 17;
+    many_seq[i] = seq++;
+    ASSERT(0 == uv_timer_start(many_timers + i, many_cb, many_due[i], 0));
+  }
+
+  ASSERT(0 == uv_run(uv_default_loop(), UV_RUN_DEFAULT));
+  ASSERT(many_cb_called == MANY_TIMERS);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
 static void tiny_timer_cb(uv_timer_t* handle) {
   ASSERT(handle == &tiny_timer);
   uv_close((uv_handle_t*) &tiny_timer, NULL);
@@ -301,3 +361,180 @@ TEST_IMPL(timer_null_callback) {
   MAKE_VALGRIND_HAPPY();
   return 0;
 }
+
+
+static uint64_t slack_fired[2];
+static int slack_cb_called;
+
+
+static void slack_cb(uv_timer_t* handle) {
+  ASSERT(handle->data == (void*) (uintptr_t) slack_cb_called);
+  slack_fired[slack_cb_called++] = uv_now(handle->loop);
+}
+
+
+TEST_IMPL(timer_slack) {
+  uv_timer_t handles[2];
+  uv_loop_t* loop;
+  uint64_t base;
+  uint64_t now;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_timer_init(loop, handles + 0));
+  ASSERT(0 == uv_timer_init(loop, handles + 1));
+  handles[0].data = (void*) 0;
+  handles[1].data = (void*) 1;
+
+  /* Both round to multiples of 128 ms. */
+  uv_timer_set_slack(handles + 0, 128);
+  uv_timer_set_slack(handles + 1, 200);
+  ASSERT(128 == uv_timer_get_slack(handles + 0));
+  ASSERT(200 == uv_timer_get_slack(handles + 1));
+
+  /* Due 80 ms apart, but inside the same 128 ms block. */
+  now = uv_now(loop);
+  base = (now + 255) & ~(uint64_t) 127;
+  ASSERT(0 == uv_timer_start(handles + 0, slack_cb, base - now - 100, 0));
+  ASSERT(0 == uv_timer_start(handles + 1, slack_cb, base - now - 20, 0));
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+
+  ASSERT(slack_cb_called == 2);
+  ASSERT(slack_fired[0] >= base);
+  ASSERT(slack_fired[0] == slack_fired[1]);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+static uv_timer_t ns_timer;
+static uv_timer_t ns_oneshot;
+static uv_timer_t ms_timer;
+static uint64_t ns_start;
+static int ns_cb_called;
+static int ns_oneshot_cb_called;
+
+
+static void ns_oneshot_cb(uv_timer_t* handle) {
+  ASSERT(handle == &ns_oneshot);
+  ASSERT(uv_hrtime() - ns_start >= 300 * 1000);
+  ns_oneshot_cb_called++;
+}
+
+
+static void ns_cb(uv_timer_t* handle) {
+  ASSERT(handle == &ns_timer);
+  ASSERT(uv_hrtime() - ns_start >= (uint64_t) (ns_cb_called + 1) * 200 * 1000);
+
+  if (++ns_cb_called == 20) {
+    uv_close((uv_handle_t*) &ns_timer, NULL);
+    uv_close((uv_handle_t*) &ns_oneshot, NULL);
+    uv_close((uv_handle_t*) &ms_timer, NULL);
+  }
+}
+
+
+static void ms_cb(uv_timer_t* handle) {
+  ASSERT(0 && "should not be called");
+}
+
+
+TEST_IMPL(timer_ns) {
+  uv_loop_t* loop;
+  uint64_t elapsed;
+  int r;
+
+  loop = uv_default_loop();
+  ASSERT(0 == uv_timer_init(loop, &ns_timer));
+  ASSERT(0 == uv_timer_init(loop, &ns_oneshot));
+  ASSERT(0 == uv_timer_init(loop, &ms_timer));
+
+  ns_start = uv_hrtime();
+  r = uv_timer_start_ns(&ns_timer, ns_cb, 200 * 1000, 200 * 1000);
+#ifndef __linux__
+  ASSERT(r == UV_ENOSYS);
+  MAKE_VALGRIND_HAPPY();
+  RETURN_SKIP("Nanosecond timers are only implemented on Linux.");
+#endif
+  ASSERT(r == 0);
+  ASSERT(200 * 1000 == uv_timer_get_repeat(&ns_timer));
+  ASSERT(UV_EINVAL == uv_timer_start_ns(&ns_oneshot, NULL, 0, 0));
+
+  /* Restarting and stopping work like for millisecond timers. */
+  ASSERT(0 == uv_timer_start_ns(&ns_oneshot, ns_oneshot_cb, 100 * 1000, 0));
+  ASSERT(0 == uv_timer_start_ns(&ns_oneshot, ns_oneshot_cb, 300 * 1000, 0));
+
+  /* A millisecond timer on the same loop doesn't interfere. */
+  ASSERT(0 == uv_timer_start(&ms_timer, ms_cb, 1000, 0));
+
+  ASSERT(0 == uv_run(loop, UV_RUN_DEFAULT));
+  elapsed = uv_hrtime() - ns_start;
+
+  ASSERT(ns_cb_called == 20);
+  ASSERT(ns_oneshot_cb_called == 1);
+  ASSERT(elapsed >= 20 * 200 * 1000);
+  ASSERT(elapsed < 1000 * 1000 * 1000);
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+}
+
+
+#ifndef _WIN32
+static int enomem_fail;
+
+static void* enomem_realloc(void* ptr, size_t size) {
+  if (enomem_fail)
+    return NULL;
+  return realloc(ptr, size);
+}
+#endif
+
+
+TEST_IMPL(timer_start_enomem) {
+#ifdef _WIN32
+  RETURN_SKIP("Windows timers don't allocate.");
+#else
+  /* The heap starts out with room for 64 timers. */
+  uv_timer_t timers[64];
+  uv_timer_t handle;
+  uv_loop_t loop;
+  unsigned int i;
+
+  ASSERT(0 == uv_replace_allocator(malloc, enomem_realloc, calloc, free));
+  ASSERT(0 == uv_loop_init(&loop));
+  ASSERT(0 == uv_timer_init(&loop, &handle));
+  ASSERT(0 == uv_timer_start(&handle, never_cb, 1000, 500));
+  ASSERT(0 == uv_timer_stop(&handle));
+
+  for (i = 0; i < ARRAY_SIZE(timers); i++) {
+    ASSERT(0 == uv_timer_init(&loop, timers + i));
+    ASSERT(0 == uv_timer_start(timers + i, never_cb, 1000, 0));
+  }
+
+  /* A start that fails leaves the timer as it was. */
+  enomem_fail = 1;
+  ASSERT(UV_ENOMEM == uv_timer_again(&handle));
+  ASSERT(UV_ENOMEM == uv_timer_start(&handle, never_cb, 1000, 0));
+  ASSERT(0 == uv_is_active((uv_handle_t*) &handle));
+  ASSERT(500 == uv_timer_get_repeat(&handle));
+
+  /* Restarting a timer that is already in the heap doesn't need memory. */
+  ASSERT(0 == uv_timer_stop(timers));
+  ASSERT(0 == uv_timer_start(timers, never_cb, 2000, 0));
+  enomem_fail = 0;
+
+  ASSERT(0 == uv_timer_again(&handle));
+  ASSERT(1 == uv_is_active((uv_handle_t*) &handle));
+
+  uv_close((uv_handle_t*) &handle, NULL);
+  for (i = 0; i < ARRAY_SIZE(timers); i++)
+    uv_close((uv_handle_t*) (timers + i), NULL);
+
+  ASSERT(0 == uv_run(&loop, UV_RUN_DEFAULT));
+  ASSERT(0 == uv_loop_close(&loop));
+
+  MAKE_VALGRIND_HAPPY();
+  return 0;
+#endif
+}
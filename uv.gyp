@@ -54,6 +54,7 @@
         'include/uv-errno.h',
         'include/uv-threadpool.h',
         'include/uv-version.h',
+        'src/dheap-inl.h',
         'src/fs-poll.c',
         'src/heap-inl.h',
         'src/inet.c',
@@ -132,6 +133,7 @@
             'include/uv-aix.h',
             'src/unix/async.c',
             'src/unix/atomic-ops.h',
+            'src/unix/channel.c',
             'src/unix/core.c',
             'src/unix/dl.c',
             'src/unix/fs.c',
@@ -139,6 +141,7 @@
             'src/unix/getnameinfo.c',
             'src/unix/internal.h',
             'src/unix/loop.c',
+            'src/unix/loop-lag.c',
             'src/unix/loop-watcher.c',
             'src/unix/pipe.c',
             'src/unix/poll.c',
@@ -149,6 +152,7 @@
             'src/unix/tcp.c',
             'src/unix/thread.c',
             'src/unix/timer.c',
+            'src/unix/timer-wheel.c',
             'src/unix/tty.c',
             'src/unix/udp.c',
           ],
@@ -199,6 +203,7 @@
           'sources': [
             'src/unix/linux-core.c',
             'src/unix/linux-inotify.c',
+            'src/unix/linux-iouring.c',
             'src/unix/linux-syscalls.c',
             'src/unix/linux-syscalls.h',
           ],
@@ -210,6 +215,7 @@
           'sources': [
             'src/unix/linux-core.c',
             'src/unix/linux-inotify.c',
+            'src/unix/linux-iouring.c',
             'src/unix/linux-syscalls.c',
             'src/unix/linux-syscalls.h',
             'src/unix/pthread-fixes.c',
@@ -286,6 +292,7 @@
         'test/test-async.c',
         'test/test-async-null-cb.c',
         'test/test-callback-stack.c',
+        'test/test-channel.c',
         'test/test-callback-order.c',
         'test/test-close-fd.c',
         'test/test-close-order.c',
@@ -318,6 +325,13 @@
         'test/test-loop-stop.c',
         'test/test-loop-time.c',
         'test/test-loop-configure.c',
+        'test/test-loop-edge-triggered.c',
+        'test/test-loop-busy-poll.c',
+        'test/test-loop-io-uring.c',
+        'test/test-loop-lag.c',
+        'test/test-loop-timer-wheel.c',
+        'test/test-loop-metrics.c',
+        'test/test-loop-poll-batch.c',
         'test/test-walk-handles.c',
         'test/test-watcher-cross-stop.c',
         'test/test-multiple-listen.c',
@@ -339,6 +353,7 @@
         'test/test-poll-closesocket.c',
         'test/test-process-title.c',
         'test/test-ref.c',
+        'test/test-reuseport.c',
         'test/test-run-nowait.c',
         'test/test-run-once.c',
         'test/test-semaphore.c',
@@ -442,6 +457,7 @@
       'sources': [
         'test/benchmark-async.c',
         'test/benchmark-async-pummel.c',
+        'test/benchmark-channel.c',
         'test/benchmark-fs-stat.c',
         'test/benchmark-getaddrinfo.c',
         'test/benchmark-list.h',
@@ -455,6 +471,8 @@
         'test/benchmark-sizes.c',
         'test/benchmark-spawn.c',
         'test/benchmark-thread.c',
+        'test/benchmark-threadpool.c',
+        'test/benchmark-timer-churn.c',
         'test/benchmark-tcp-write-batch.c',
         'test/benchmark-udp-pummel.c',
         'test/dns-server.c',